@@ -12,9 +12,14 @@
  * License: MIT
  */
 
+#define _GNU_SOURCE   /* For recvmmsg (batched input engine, Linux) */
+
 #include <gst/gst.h>
 #include <gst/app/gstappsink.h>
 #include <gst/app/gstappsrc.h>
+#include <gst/net/net.h>  /* For PTP/NTP clock slaving (--clock) */
+#include <gio/gio.h>  /* For GSocketService (metrics endpoint) */
+#include <gio/gunixsocketaddress.h>  /* For the control socket */
 #include <stdio.h>
 #include <stdlib.h>   /* For atoi, strtoull */
 #include <string.h>
@@ -22,6 +27,18 @@
 #include <unistd.h>   /* For standard POSIX definitions */
 #include <signal.h>   /* For signal, SIGINT */
 #include <getopt.h>
+#include <sys/time.h>     /* For struct timeval (rusage) */
+#include <sys/resource.h> /* For getrusage, benchmark CPU accounting */
+
+#include <pthread.h>      /* For render-thread scheduling (--rt-priority) */
+#include <sched.h>        /* For SCHED_FIFO, CPU affinity */
+
+#ifdef __linux__
+#include <sys/socket.h>   /* For recvmmsg (batched input engine) */
+#include <netinet/in.h>
+#include <arpa/inet.h>    /* For htons/htonl */
+#include <errno.h>
+#endif
 
 /* ========== Version ========== */
 #define VERSION "1.1.0"
@@ -65,6 +82,21 @@
 #define DEFAULT_RTP_MTU             1200
 #define DEFAULT_NO_SIGNAL_TIMEOUT   5000000000  /* 5 seconds in nanoseconds */
 
+/* Watchdog defaults */
+#define DEFAULT_STALL_TIMEOUT_MS    10000       /* Force input restart after 10s stall */
+#define WATCHDOG_CHECK_MS           1000
+
+/* Audio channel defaults */
+#define AUDIO_RATE        48000
+#define AUDIO_CHANNELS    2
+#define AUDIO_CHUNK_NS    (20 * GST_MSECOND)
+#define AUDIO_CHUNK_BYTES (AUDIO_RATE / 50 * AUDIO_CHANNELS * 2)  /* 20ms S16LE */
+
+/* Adaptive jitter buffer defaults */
+#define DEFAULT_JITTER_MIN_MS       50          /* Floor for --jitter-adaptive */
+#define DEFAULT_JITTER_MAX_MS       4000        /* Ceiling for --jitter-adaptive */
+#define JITTER_ADAPT_CHECK_MS       2000
+
 /* ========== Enums ========== */
 
 typedef enum {
@@ -75,6 +107,32 @@ typedef enum {
     CODEC_VP9       /* vp9enc */
 } OutputCodec;
 
+typedef enum {
+    HW_NONE,        /* Software encoders (x264enc, x265enc, ...) */
+    HW_AUTO,        /* Probe VAAPI -> NVENC -> V4L2, fall back to software */
+    HW_VAAPI,       /* Intel/AMD via vah264enc or vaapih264enc */
+    HW_NVENC,       /* NVIDIA via nvh264enc / nvh265enc */
+    HW_V4L2         /* V4L2 stateful encoders (SoCs) */
+} HwBackend;
+
+typedef enum {
+    ACCEL_NONE,     /* Software videoconvert + videoscale */
+    ACCEL_AUTO,     /* Probe VAAPI postproc -> GL, fall back to software */
+    ACCEL_GL,       /* glupload ! glcolorconvert ! glcolorscale ! gldownload */
+    ACCEL_VAAPI     /* vapostproc or vaapipostproc */
+} InputAccel;
+
+typedef enum {
+    ENGINE_STOCK,       /* GStreamer udpsrc (one syscall per datagram) */
+    ENGINE_BATCHED      /* recvmmsg batches into appsrc (Linux only) */
+} InputEngine;
+
+typedef enum {
+    PROTO_UDP,          /* Bare UDP MPEG-TS (historic default) */
+    PROTO_SRT,          /* SRT listener (srtsrc) */
+    PROTO_RIST          /* RIST receiver (ristsrc) */
+} InputProto;
+
 typedef enum {
     CONTAINER_RTP,      /* RTP payload over UDP */
     CONTAINER_MPEGTS,   /* MPEG-TS over UDP */
@@ -83,9 +141,137 @@ typedef enum {
     CONTAINER_FILE      /* File output (mp4, mkv, ts) */
 } OutputContainer;
 
+/* ========== Stats Counters ========== */
+
+/*
+ * Each counter block is owned by exactly one writer thread and padded to
+ * its own cache line, so counting never bounces lines between the appsink
+ * streaming thread and the render loop. Single-writer means plain
+ * read-modify on the owner side; publication uses relaxed atomic stores
+ * so readers (stats tick, metrics endpoint) can never see torn 64-bit
+ * values on 32-bit/ARM hosts. Relaxed costs nothing on x86.
+ */
+#define STAT_SET(field, v) __atomic_store_n(&(field), (v), __ATOMIC_RELAXED)
+#define STAT_ADD(field, n) __atomic_store_n(&(field), (field) + (n), __ATOMIC_RELAXED)
+#define STAT_INC(field)    STAT_ADD(field, 1)
+#define STAT_READ(field)   __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
+/* The rare counter with more than one writer thread needs a real RMW */
+#define STAT_FETCH_ADD(field, n) __atomic_fetch_add(&(field), (n), __ATOMIC_RELAXED)
+
+/* Written only by the appsink streaming thread (on_new_sample) */
+typedef struct {
+    guint64 frames_in;
+    guint64 in_seq;             /* Never read cross-thread (seq rides the slot) */
+} __attribute__((aligned(64))) InputStats;
+
+/* Written only by the render loop */
+typedef struct {
+    guint64 frames_out;
+    guint64 frames_repeated;
+    guint64 frames_cached;      /* Repeats served from the repeat cache */
+    guint64 last_pushed_seq;    /* Consumer state, kept on the consumer's line */
+    guint64 wakeups_late;       /* Clock waits that returned >1ms past target */
+    guint64 pushes_dropped;     /* Ticks dropped because the push queue was full */
+    guint64 last_content_hash;  /* Consumer state for --change-detect */
+    gint signal_lost;           /* 1 while the output is on the fallback frame */
+} __attribute__((aligned(64))) OutputStats;
+
+/* Coherent-enough snapshot for reporting paths */
+typedef struct {
+    guint64 frames_in;
+    guint64 frames_out;
+    guint64 frames_repeated;
+    guint64 frames_cached;
+    guint64 wakeups_late;
+    gint signal_lost;
+} StatsSnapshot;
+
+/* ========== Latency Histogram ========== */
+
+/* Fixed 1 ms buckets; the last bucket collects everything >= 127 ms.
+ * Recording is one array increment - cheap enough for the render loop. */
+#define LATENCY_BUCKETS 128
+
+typedef struct {
+    guint64 buckets[LATENCY_BUCKETS];
+    guint64 count;
+    guint64 total_ns;           /* Sum of recorded deltas (Prometheus _sum) */
+    guint64 max_ns;             /* Max since start */
+    guint64 interval_max_ns;    /* Max since the last stats tick (reset there) */
+} LatencyHist;
+
+/* Single writer (render thread); published with relaxed stores so the
+ * metrics endpoint can read it torn-free, same scheme as the counters */
+static void latency_hist_add(LatencyHist *h, GstClockTime delta_ns) {
+    guint64 ms = delta_ns / GST_MSECOND;
+    if (ms >= LATENCY_BUCKETS) ms = LATENCY_BUCKETS - 1;
+    STAT_INC(h->buckets[ms]);
+    STAT_INC(h->count);
+    STAT_ADD(h->total_ns, delta_ns);
+    if (delta_ns > h->max_ns) STAT_SET(h->max_ns, delta_ns);
+    if (delta_ns > h->interval_max_ns) STAT_SET(h->interval_max_ns, delta_ns);
+}
+
+/* out = cur - prev, bucket-wise; used to report per-interval percentiles
+ * so the stats tick shows latency drift, not a lifetime average */
+static void latency_hist_diff(const LatencyHist *cur, const LatencyHist *prev,
+                              LatencyHist *out) {
+    out->count = STAT_READ(cur->count) - prev->count;
+    out->max_ns = STAT_READ(cur->interval_max_ns);  /* Max since the last tick */
+    out->interval_max_ns = out->max_ns;
+    for (guint i = 0; i < LATENCY_BUCKETS; i++) {
+        out->buckets[i] = STAT_READ(cur->buckets[i]) - prev->buckets[i];
+    }
+}
+
+/* Returns the bucket upper bound in ms holding the given percentile */
+static guint latency_hist_percentile(const LatencyHist *h, gdouble pct) {
+    guint64 count = STAT_READ(h->count);
+    if (count == 0) return 0;
+    guint64 target = (guint64)(pct / 100.0 * (gdouble)count);
+    if (target >= count) target = count - 1;
+    guint64 cumulative = 0;
+    for (guint i = 0; i < LATENCY_BUCKETS; i++) {
+        cumulative += STAT_READ(h->buckets[i]);
+        if (cumulative > target) return i;
+    }
+    return LATENCY_BUCKETS - 1;
+}
+
 /* ========== Data Structures ========== */
 
+/**
+ * FrameSlot - one cell of the lock-free triple buffer.
+ *
+ * Three slots rotate between exactly two threads:
+ * - the appsink streaming thread (producer, on_new_sample)
+ * - the render loop (consumer)
+ * plus a "pending" mailbox that both sides swap against atomically.
+ * Each side owns its slot outright between swaps, so slot contents
+ * never need a lock.
+ */
+typedef struct {
+    GstBuffer *buffer;          /* Ref held by the slot (NULL until first frame) */
+    GstClockTime input_time;    /* Monotonic arrival time in ns */
+    guint64 seq;                /* Input sequence number */
+    guint64 content_hash;       /* Sampled Y-plane checksum, 0 = not computed */
+} FrameSlot;
+
+typedef struct _FrameBuffer FrameBuffer;
+
+/* Routes bus messages back to their channel + pipeline; one instance per
+ * pipeline lives inside the owning FrameBuffer */
 typedef struct {
+    FrameBuffer *fb;
+    const char *pipeline_name;  /* "INPUT" / "OUTPUT" */
+} BusContext;
+
+struct _FrameBuffer {
+    /* Channel identity: "FrameBuffer" for the classic single-channel CLI,
+     * "FrameBuffer:<section>" for channels from a --config file */
+    gchar *log_name;
+
     /* Pipelines */
     GstElement *input_pipeline;
     GstElement *output_pipeline;
@@ -94,37 +280,133 @@ typedef struct {
     GstElement *appsink;
     GstElement *appsrc;
 
-    /* Frame buffer (single frame, mutex protected) */
-    GstBuffer *current_frame;
-    GstCaps *current_caps;
+    /* Frame buffer (lock-free triple buffer, see FrameSlot)
+     *
+     * The old single-slot-plus-mutex design let a bursty input thread
+     * (jitter buffer draining, caps swap) block the render loop past its
+     * clock deadline. Now the producer fills its private slot and swaps it
+     * into `pending_slot` with one atomic exchange; the consumer swaps it
+     * out the same way. Neither side ever waits. */
+    FrameSlot slots[3];
+    FrameSlot *input_slot;        /* Owned by on_new_sample between swaps */
+    FrameSlot *output_slot;       /* Owned by render_loop; holds last good frame */
+    FrameSlot *pending_slot;      /* Mailbox, accessed only via atomic exchange */
+    gint frame_available;         /* Atomic flag: pending_slot holds a newer frame */
+    gint producer_busy;           /* CAS guard: slot producer exclusivity on failover */
+    GstCaps *current_caps;        /* Producer-thread only, for caps-change logging */
     GstBuffer *fallback_frame;    /* Pre-allocated grey frame (avoid memory churn) */
-    GstClockTime last_input_time; /* For no-signal timeout detection */
-    GMutex frame_mutex;
+    gchar *fallback_image;        /* Optional PNG/JPEG decoded once into the slate */
+    GstBufferPool *pool;          /* Pre-sized I420 pool; all locally-created raw
+                                   * frames come from here so steady-state runs
+                                   * do zero heap allocations on the frame path */
 
     /* Render loop */
     GThread *render_thread;
     gboolean running;
 
+    /* Pipelined push stage
+     *
+     * The clock-driven pacer never calls gst_app_src_push_buffer() itself:
+     * it drops each buffer into a small bounded queue drained by a
+     * dedicated feeder thread. A transient encoder stall (scene-change
+     * bitrate spike at ultrafast) consumes queue slack instead of shoving
+     * the next clock wait past its slot. When the slack is gone the
+     * pacer drops that tick's frame rather than distort the cadence. */
+    GAsyncQueue *push_queue;
+    GThread *push_thread;
+    gint push_flushing;         /* Atomic: downstream returned FLUSHING/EOS */
+
     /* Auto-recovery */
     gboolean input_restart_pending;
     guint restart_timeout_id;
-
-    /* Stats */
-    guint64 frames_in;
-    guint64 frames_out;
-    guint64 frames_repeated;
-    guint64 in_seq;
-    guint64 last_pushed_seq;
+    guint64 restart_count;      /* Input pipeline restarts (main-loop thread) */
+    gint64 last_decoder_rebuild_ms;  /* Rate-limits the hitless rebuild path */
+
+    /* Warm standby (--warm-standby): a second input pipeline, pre-parsed
+     * and held in READY (sockets unbound, plugins loaded). On input error
+     * it is promoted to PLAYING immediately and a fresh standby is rebuilt
+     * off the recovery critical path. */
+    gboolean warm_standby;
+    GstElement *standby_pipeline;
+    GstElement *standby_appsink;
+    guint standby_build_id;     /* Idle source rebuilding the standby */
+
+    /* Stall watchdog: bus errors don't fire when an upstream encoder keeps
+     * the socket open but stops sending; this does */
+    guint64 stall_timeout_ms;   /* 0 = watchdog off */
+    guint watchdog_timer_id;
+    guint64 watchdog_last_frames;
+    guint64 watchdog_stalled_ms;
+    guint watchdog_backoff;     /* Consecutive fruitless restarts (exponential) */
+
+    /* Stats (per-writer cache lines, see StatsCounters section) */
+    InputStats stats_in;
+    OutputStats stats_out;
+    guint64 frame_path_allocs;  /* Heap allocs on the frame path (pool misses,
+                                 * batched-receive buffers); multiple writer
+                                 * threads, so updated with STAT_FETCH_ADD.
+                                 * Verifies the pool's zero-alloc claim. */
+    LatencyHist latency;        /* Slot-store -> push latency (render thread) */
+    LatencyHist latency_prev;   /* Snapshot at the last stats tick */
+
+    /* Benchmark mode (--bench): synthetic input, report on exit */
+    gboolean bench;
+    gint bench_duration;        /* Seconds */
 
     /* Input config */
     gint input_port;
     guint64 udp_buffer_size;
     guint64 jitter_buffer_ms;
     guint64 max_queue_time_ms;
+    gboolean change_detect;     /* Treat content-identical frames as repeats */
+    InputAccel input_accel;     /* GPU convert/scale in the input pipeline */
+    gboolean accel_resolved;    /* Registry probe done (input pipeline can restart) */
+    const gchar *accel_chain;   /* Resolved convert/scale fragment, NULL = software */
+    /* Dual-input failover (--backup-port)
+     *
+     * Both pipelines feed handle_input_sample(); only the active one may
+     * publish into the frame slot, the standby just refreshes its health
+     * timestamp. A 50 ms main-loop timer compares arrival freshness and
+     * promotes/demotes by flipping active_input - no pipeline rebuild on
+     * the switch, so output continuity is a frame or two, not seconds. */
+    gint backup_port;             /* 0 = no backup input */
+    GstElement *backup_pipeline;
+    GstElement *backup_appsink;
+    gint active_input;            /* Atomic: INPUT_PRIMARY / INPUT_BACKUP */
+    guint64 primary_last_ns;      /* Last arrival per input (atomic publication) */
+    guint64 backup_last_ns;
+    guint failover_timer_id;
+    guint64 failover_count;       /* Promotions to backup (main-loop thread) */
+
+    /* Adaptive jitter buffer (--jitter-adaptive)
+     *
+     * The producer thread keeps RFC3550-style EWMAs of the inter-arrival
+     * interval and its deviation; a main-loop timer sizes the queue
+     * threshold from them, between a floor and a ceiling. Clean LAN feeds
+     * converge to tens of milliseconds instead of paying the fixed
+     * second; lossy WAN paths grow the buffer before frames repeat. */
+    gboolean jitter_adaptive;
+    guint64 jitter_min_ms;
+    guint64 jitter_max_ms;
+    guint64 jitter_current_ms;    /* Applied threshold (main-loop thread) */
+    guint64 last_arrival_ns;      /* Producer thread only */
+    guint64 mean_interval_ns;     /* Producer thread only */
+    guint64 arrival_jitter_ns;    /* EWMA deviation, atomic publication */
+    guint jitter_timer_id;
+
+    InputProto input_proto;     /* udp, srt or rist transport */
+    InputEngine input_engine;   /* Stock udpsrc or recvmmsg front-end (udp only) */
+    GstElement *net_appsrc;     /* "netsrc" of the batched front-end */
+    GThread *recv_thread;       /* recvmmsg loop (batched engine) */
+    gboolean recv_running;
 
     /* Output config */
     gint output_port;
     gchar *output_host;
+    GPtrArray *extra_dests;     /* Additional "host:port" strings (--dest) */
+    gchar *record_file;         /* Simultaneous recording branch (--record) */
+    gint preview_port;          /* Low-fps MJPEG monitoring tap, 0 = off */
+    gint preview_fps;
     gint width;
     gint height;
     gint fps;
@@ -134,13 +416,66 @@ typedef struct {
     /* Output format */
     OutputCodec codec;
     OutputContainer container;
+    HwBackend hw;               /* Requested backend; resolved before pipeline build */
+    const gchar *hw_factory;    /* Concrete encoder factory name once resolved */
+
+    /* Audio passthrough channel (--audio)
+     *
+     * decodebin3's audio pad feeds a small ring through a second appsink
+     * (S16LE 48k stereo); the render loop forwards it re-timed alongside
+     * the video and silence-fills gaps, mirroring the video fallback
+     * concept. Re-encoded to AAC and remuxed into mpegts/mp4 outputs. */
+    gboolean audio_enable;
+    GstElement *audio_appsink;    /* "asink" in the input pipeline */
+    GstElement *audio_appsrc;     /* "asrc" in the output pipeline */
+    GAsyncQueue *audio_queue;     /* Raw audio, input thread -> render loop */
+    GstBuffer *silence_frame;     /* Pre-allocated 20ms of silence */
+    guint64 audio_pts;            /* Audio timeline position (render thread) */
+    const gchar *aac_factory;     /* avenc_aac or voaacenc, probed */
+
+    /* Compressed-domain passthrough (--passthrough)
+     *
+     * For h264-in / h264-out channels the decode -> I420 -> re-encode
+     * round trip is pure waste. The input pipeline taps parsed access
+     * units after tsdemux/h264parse (before any decoder); the render
+     * loop retimes and forwards one AU per tick and keeps the last
+     * IDR-led GOP for replay on stall. The raw frame slot is unused. */
+    gboolean passthrough;
+    gboolean passthrough_checked; /* Validation ran (both pipelines call it) */
+    GAsyncQueue *au_queue;        /* Parsed AUs, input thread -> render loop */
+    GPtrArray *gop_cache;         /* Last IDR-led GOP (render thread only) */
+    guint gop_pos;                /* Replay cursor */
+    gboolean gop_complete;        /* Cache currently starts at a keyframe */
+    gboolean await_keyframe;      /* Resyncing after an overflow drop */
+
+    /* Encoded-frame repeat cache (--repeat-cache)
+     *
+     * When enabled the output is split in two: an encode stage
+     * (appsrc -> encoder -> parse -> appsink) and a send stage
+     * (appsrc -> mux/pay -> sink). Encoded frames are forwarded between
+     * the two in on_encoded_sample(), which also keeps a ref on the last
+     * keyframe. Once a stall has lasted a full GOP (so the cached
+     * keyframe is guaranteed to show the stalled picture), the render
+     * loop retimes and replays that keyframe instead of pushing raw
+     * pixels through the encoder - an idle channel stops paying for a
+     * full encode session. */
+    gboolean repeat_cache;
+    GstElement *encode_pipeline;  /* NULL unless repeat_cache */
+    GstElement *enc_appsink;
+    GstElement *mux_appsrc;
+    GstBuffer *cached_keyframe;   /* Atomic pointer, exchanged between threads */
+    GstBuffer *slate_keyframe;    /* Pre-encoded slate, re-published into the
+                                   * cache when signal loss is declared */
+    GstCaps *enc_caps;            /* Encoder-thread only, for mux caps updates */
 
     /* Shared memory config */
     gchar *shm_path;
     guint64 shm_size;
+    gboolean shm_zero_copy;     /* unixfdsink (memfd handle passing) vs shmsink */
 
     /* File output config */
     gchar *output_file;
+    gint segment_seconds;       /* 0 = single file, N = rotating segments */
 
     /* Appsink config */
     gint appsink_max_buffers;
@@ -148,25 +483,103 @@ typedef struct {
     /* Stats config */
     gint stats_interval;
 
+    /* Render-thread scheduling (--rt-priority / --cpu-affinity) */
+    gint rt_priority;           /* SCHED_FIFO priority, 0 = normal scheduling */
+    guint64 cpu_affinity_mask;  /* Bitmask of allowed CPUs, 0 = unset */
+
+    /* Fast start (--fast-start): output pipeline and render thread come up
+     * first (fallback frames flow within ~100ms of process start); the
+     * input pipeline is built from an idle callback off the critical path */
+    gboolean fast_start;
+
     /* Verbose output */
     gboolean verbose;
 
-    GMainLoop *loop;
-} FrameBuffer;
+    /* Bus message routing */
+    BusContext input_bus_ctx;
+    BusContext output_bus_ctx;
+    BusContext encode_bus_ctx;
+    BusContext backup_bus_ctx;
+    BusContext standby_bus_ctx;
+};
+
+#define INPUT_PRIMARY 0
+#define INPUT_BACKUP  1
+#define FAILOVER_CHECK_MS 50
 
 /* ========== Forward Declarations ========== */
 static GstFlowReturn on_new_sample(GstElement *sink, FrameBuffer *fb);
 static gpointer render_loop(gpointer data);
 static GstBuffer *create_fallback_frame(FrameBuffer *fb);
 static void on_bus_error(GstBus *bus, GstMessage *msg, gpointer data);
+static void on_bus_warning(GstBus *bus, GstMessage *msg, gpointer data);
+static void on_bus_eos(GstBus *bus, GstMessage *msg, gpointer data);
 static gboolean restart_input_pipeline(gpointer data);
 static gboolean create_input_pipeline(FrameBuffer *fb);
+static void start_recv_thread(FrameBuffer *fb);
+static void stop_recv_thread(FrameBuffer *fb);
+static gboolean create_backup_pipeline(FrameBuffer *fb);
+static gboolean create_standby_input_pipeline(FrameBuffer *fb);
+static gboolean build_standby_idle(gpointer data);
+static GstFlowReturn on_passthrough_sample(GstElement *sink, FrameBuffer *fb);
+static void validate_passthrough(FrameBuffer *fb);
+static GstFlowReturn on_audio_sample(GstElement *sink, FrameBuffer *fb);
+static void validate_audio(FrameBuffer *fb);
+static GstFlowReturn enqueue_push(FrameBuffer *fb, GstElement *target, GstBuffer *buffer);
+static gboolean push_queue_has_slack(FrameBuffer *fb);
+
+typedef enum {
+    CLOCK_DEFAULT,  /* Pipeline-selected clock (historic behavior) */
+    CLOCK_SYSTEM,   /* Explicit system monotonic clock */
+    CLOCK_PTP,      /* IEEE1588, fleet-wide lockstep */
+    CLOCK_NTP       /* GstNtpClock against --clock-server */
+} ClockMode;
+
+/* Shared main loop: all channels run on it, signal handler quits it */
+static GMainLoop *g_loop = NULL;
 
-/* Global reference for signal handler and auto-recovery (declared before signal_handler) */
-static FrameBuffer *g_fb = NULL;
+/* Process-wide network clock all output pipelines slave to (--clock) */
+static GstClock *g_net_clock = NULL;
+
+/* Channel set, published before the main loop starts; the metrics endpoint
+ * iterates it read-only */
+static GPtrArray *g_channels = NULL;
 
 /* ========== Helper Functions ========== */
 
+/* Channel-aware logging: every message carries the channel's log_name so a
+ * 60-channel host can tell its streams apart */
+static void fb_log(FrameBuffer *fb, const char *fmt, ...) G_GNUC_PRINTF(2, 3);
+static void fb_log(FrameBuffer *fb, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    gchar *msg = g_strdup_vprintf(fmt, args);
+    va_end(args);
+    g_print("[%s] %s", fb->log_name, msg);
+    g_free(msg);
+}
+
+static void fb_logerr(FrameBuffer *fb, const char *fmt, ...) G_GNUC_PRINTF(2, 3);
+static void fb_logerr(FrameBuffer *fb, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    gchar *msg = g_strdup_vprintf(fmt, args);
+    va_end(args);
+    g_printerr("[%s] %s", fb->log_name, msg);
+    g_free(msg);
+}
+
+/* Atomic per-field snapshot of both writers' counters; fields are read
+ * independently (no cross-field transaction), which is all reporting needs */
+static void stats_snapshot(FrameBuffer *fb, StatsSnapshot *s) {
+    s->frames_in = STAT_READ(fb->stats_in.frames_in);
+    s->frames_out = STAT_READ(fb->stats_out.frames_out);
+    s->frames_repeated = STAT_READ(fb->stats_out.frames_repeated);
+    s->frames_cached = STAT_READ(fb->stats_out.frames_cached);
+    s->wakeups_late = STAT_READ(fb->stats_out.wakeups_late);
+    s->signal_lost = STAT_READ(fb->stats_out.signal_lost);
+}
+
 static const char *codec_to_string(OutputCodec codec) {
     switch (codec) {
         case CODEC_RAW:  return "raw";
@@ -189,12 +602,52 @@ static const char *container_to_string(OutputContainer container) {
     }
 }
 
-static OutputCodec string_to_codec(const char *str) {
+static gboolean element_exists(const char *factory_name) {
+    GstElementFactory *factory = gst_element_factory_find(factory_name);
+    if (factory) {
+        gst_object_unref(factory);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static const char *hw_to_string(HwBackend hw) {
+    switch (hw) {
+        case HW_NONE:  return "none";
+        case HW_AUTO:  return "auto";
+        case HW_VAAPI: return "vaapi";
+        case HW_NVENC: return "nvenc";
+        case HW_V4L2:  return "v4l2";
+        default:       return "unknown";
+    }
+}
+
+static HwBackend string_to_hw(const char *str) {
+    if (strcasecmp(str, "auto") == 0) return HW_AUTO;
+    if (strcasecmp(str, "vaapi") == 0) return HW_VAAPI;
+    if (strcasecmp(str, "nvenc") == 0) return HW_NVENC;
+    if (strcasecmp(str, "v4l2") == 0) return HW_V4L2;
+    return HW_NONE;
+}
+
+/* Accepts plain codec names plus codec-backend shorthands like "h264-vaapi"
+ * (equivalent to "-c h264 --hw vaapi") */
+static OutputCodec string_to_codec(const char *str, HwBackend *hw) {
     if (strcasecmp(str, "raw") == 0 || strcasecmp(str, "none") == 0) return CODEC_RAW;
     if (strcasecmp(str, "h264") == 0 || strcasecmp(str, "avc") == 0) return CODEC_H264;
     if (strcasecmp(str, "h265") == 0 || strcasecmp(str, "hevc") == 0) return CODEC_H265;
     if (strcasecmp(str, "vp8") == 0) return CODEC_VP8;
     if (strcasecmp(str, "vp9") == 0) return CODEC_VP9;
+
+    if (strncasecmp(str, "h264-", 5) == 0) {
+        if (hw) *hw = string_to_hw(str + 5);
+        return CODEC_H264;
+    }
+    if (strncasecmp(str, "h265-", 5) == 0 || strncasecmp(str, "hevc-", 5) == 0) {
+        if (hw) *hw = string_to_hw(str + 5);
+        return CODEC_H265;
+    }
+
     return CODEC_H264;  /* Default */
 }
 
@@ -208,25 +661,134 @@ static OutputContainer string_to_container(const char *str) {
     return CONTAINER_RTP;  /* Default */
 }
 
+/* ========== Hitless Decoder Rebuild ========== */
+
+/* Link fresh decodebin3 video pads to the (named) convert chain; audio
+ * pads are left unlinked exactly like the original parse-launch setup */
+static void on_decoder_pad_added(GstElement *dec, GstPad *pad, gpointer data) {
+    (void)dec;
+    FrameBuffer *fb = (FrameBuffer *)data;
+
+    gchar *pad_name = gst_pad_get_name(pad);
+    gboolean is_video = (strncmp(pad_name, "video", 5) == 0);
+    g_free(pad_name);
+    if (!is_video) return;
+
+    /* A full restart may have detached the pipeline on another path */
+    if (!fb->input_pipeline) return;
+
+    GstElement *conv = gst_bin_get_by_name(GST_BIN(fb->input_pipeline), "conv");
+    if (!conv) return;
+
+    GstPad *sinkpad = gst_element_get_static_pad(conv, "sink");
+    if (!gst_pad_is_linked(sinkpad)) {
+        if (gst_pad_link(pad, sinkpad) != GST_PAD_LINK_OK) {
+            fb_logerr(fb, "Failed to link rebuilt decoder to convert chain\n");
+        }
+    }
+    gst_object_unref(sinkpad);
+    gst_object_unref(conv);
+}
+
+static GstPadProbeReturn block_probe_cb(GstPad *pad, GstPadProbeInfo *info,
+                                        gpointer user_data) {
+    (void)pad;
+    (void)info;
+    (void)user_data;
+    return GST_PAD_PROBE_OK;
+}
+
+/**
+ * Replace only the decodebin3 inside the running input pipeline: block
+ * tsparse's src pad, swap the decoder, unblock. The appsink / frame-slot
+ * path is never torn down, so the render loop keeps pacing the last good
+ * frame and a 720p<->1080i source flip costs zero output disruption
+ * instead of the full multi-second restart.
+ */
+static gboolean rebuild_decoder(FrameBuffer *fb) {
+    if (!fb->input_pipeline) return FALSE;
+
+    GstElement *tsp = gst_bin_get_by_name(GST_BIN(fb->input_pipeline), "tsp");
+    GstElement *dec = gst_bin_get_by_name(GST_BIN(fb->input_pipeline), "dec");
+    if (!tsp || !dec) {
+        /* Bench or passthrough-style pipelines have no decoder to swap */
+        if (tsp) gst_object_unref(tsp);
+        if (dec) gst_object_unref(dec);
+        return FALSE;
+    }
+
+    GstPad *tsp_src = gst_element_get_static_pad(tsp, "src");
+    gulong probe_id = gst_pad_add_probe(tsp_src, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+                                        block_probe_cb, NULL, NULL);
+
+    gst_element_set_state(dec, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(fb->input_pipeline), dec);
+    gst_object_unref(dec);
+
+    GstElement *newdec = gst_element_factory_make("decodebin3", "dec");
+    if (!newdec) {
+        gst_pad_remove_probe(tsp_src, probe_id);
+        gst_object_unref(tsp_src);
+        gst_object_unref(tsp);
+        return FALSE;
+    }
+
+    gst_bin_add(GST_BIN(fb->input_pipeline), newdec);
+    g_signal_connect(newdec, "pad-added", G_CALLBACK(on_decoder_pad_added), fb);
+    gst_element_link(tsp, newdec);
+    gst_element_sync_state_with_parent(newdec);
+
+    gst_pad_remove_probe(tsp_src, probe_id);
+    gst_object_unref(tsp_src);
+    gst_object_unref(tsp);
+
+    return TRUE;
+}
+
 /* ========== Bus Message Handlers ========== */
 static void on_bus_error(GstBus *bus, GstMessage *msg, gpointer data) {
     (void)bus;
-    const char *pipeline_name = (const char *)data;
+    BusContext *ctx = (BusContext *)data;
+    FrameBuffer *fb = ctx->fb;
     GError *err = NULL;
     gchar *debug = NULL;
 
     gst_message_parse_error(msg, &err, &debug);
-    g_printerr("[FrameBuffer] %s ERROR: %s\n", pipeline_name, err->message);
+    fb_logerr(fb, "%s ERROR: %s\n", ctx->pipeline_name, err->message);
     if (debug) {
-        g_printerr("[FrameBuffer] Debug: %s\n", debug);
+        fb_logerr(fb, "Debug: %s\n", debug);
     }
 
     /* Auto-restart input pipeline on errors (codec change, stream errors, etc.)
-     * This keeps FrameBuffer decoupled from source - it handles errors internally */
-    if (strcmp(pipeline_name, "INPUT") == 0 && g_fb && !g_fb->input_restart_pending) {
-        g_fb->input_restart_pending = TRUE;
-        g_print("[FrameBuffer] Input error detected, scheduling auto-restart in 1s...\n");
-        g_fb->restart_timeout_id = g_timeout_add(1000, restart_input_pipeline, g_fb);
+     * This keeps FrameBuffer decoupled from source - it handles errors internally.
+     *
+     * First recovery attempt is the hitless in-place decoder rebuild (the
+     * usual cause is a caps/codec flip that only kills the decoder).
+     * Rate-limited: a second error within 10s means the problem is bigger
+     * than the decoder, escalate to the full restart path. */
+    if (strcmp(ctx->pipeline_name, "INPUT") == 0 && !fb->input_restart_pending) {
+        gint64 now_ms = g_get_monotonic_time() / 1000;
+        if ((now_ms - fb->last_decoder_rebuild_ms) > 10000 && rebuild_decoder(fb)) {
+            fb->last_decoder_rebuild_ms = now_ms;
+            fb_log(fb, "Input error recovered with in-place decoder rebuild\n");
+        } else {
+            fb->input_restart_pending = TRUE;
+            fb_log(fb, "Input error detected, scheduling auto-restart in 1s...\n");
+            fb->restart_timeout_id = g_timeout_add(1000, restart_input_pipeline, fb);
+        }
+    } else if (strcmp(ctx->pipeline_name, "STANDBY") == 0) {
+        /* A broken standby only costs us the spare: throw it away and
+         * rebuild one off the critical path - never touch the live input */
+        fb_log(fb, "Standby pipeline error, discarding and rebuilding the spare\n");
+        if (fb->standby_pipeline) {
+            gst_element_set_state(fb->standby_pipeline, GST_STATE_NULL);
+            gst_object_unref(fb->standby_pipeline);
+            fb->standby_pipeline = NULL;
+            fb->standby_appsink = NULL;
+        }
+        if (!fb->standby_build_id) {
+            fb->standby_build_id = g_idle_add(build_standby_idle, fb);
+        }
     }
 
     g_error_free(err);
@@ -239,22 +801,59 @@ static void on_bus_error(GstBus *bus, GstMessage *msg, gpointer data) {
 static gboolean restart_input_pipeline(gpointer data) {
     FrameBuffer *fb = (FrameBuffer *)data;
 
-    g_print("[FrameBuffer] Restarting input pipeline for auto-recovery...\n");
+    fb_log(fb, "Restarting input pipeline for auto-recovery...\n");
+    fb->restart_count++;
 
-    /* Stop old input pipeline */
+    /* Stop old input pipeline (and its receive thread, which holds the
+     * appsrc of the pipeline being torn down) */
+    stop_recv_thread(fb);
     if (fb->input_pipeline) {
         gst_element_set_state(fb->input_pipeline, GST_STATE_NULL);
         gst_object_unref(fb->input_pipeline);
         fb->input_pipeline = NULL;
         fb->appsink = NULL;
+        fb->net_appsrc = NULL;
     }
 
-    /* Create new input pipeline */
-    if (create_input_pipeline(fb)) {
+    if (fb->warm_standby && fb->standby_pipeline) {
+        /* Promote the pre-built standby: no parse, no plugin loading - just
+         * a state change and renegotiation. Rebuild a fresh standby off the
+         * critical path. */
+        fb->input_pipeline = fb->standby_pipeline;
+        fb->appsink = fb->standby_appsink;
+        fb->standby_pipeline = NULL;
+        fb->standby_appsink = NULL;
+        if (fb->input_engine == ENGINE_BATCHED && !fb->bench) {
+            fb->net_appsrc = gst_bin_get_by_name(GST_BIN(fb->input_pipeline), "netsrc");
+        }
+
+        /* The promoted pipeline IS the live input now: rewire its bus
+         * handlers from the STANDBY context (discard-and-rebuild) to the
+         * INPUT context (decoder rebuild / restart recovery) */
+        {
+            GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(fb->input_pipeline));
+            g_signal_handlers_disconnect_by_data(bus, &fb->standby_bus_ctx);
+            g_signal_connect(bus, "message::error", G_CALLBACK(on_bus_error),
+                             &fb->input_bus_ctx);
+            g_signal_connect(bus, "message::warning", G_CALLBACK(on_bus_warning),
+                             &fb->input_bus_ctx);
+            g_signal_connect(bus, "message::eos", G_CALLBACK(on_bus_eos),
+                             &fb->input_bus_ctx);
+            gst_object_unref(bus);
+        }
+        gst_element_set_state(fb->input_pipeline, GST_STATE_PLAYING);
+        start_recv_thread(fb);
+        fb_log(fb, "Warm standby promoted to live input\n");
+
+        if (!fb->standby_build_id) {
+            fb->standby_build_id = g_idle_add(build_standby_idle, fb);
+        }
+    } else if (create_input_pipeline(fb)) {
         gst_element_set_state(fb->input_pipeline, GST_STATE_PLAYING);
-        g_print("[FrameBuffer] Input pipeline restarted successfully\n");
+        start_recv_thread(fb);
+        fb_log(fb, "Input pipeline restarted successfully\n");
     } else {
-        g_printerr("[FrameBuffer] Failed to restart input pipeline!\n");
+        fb_logerr(fb, "Failed to restart input pipeline!\n");
     }
 
     fb->input_restart_pending = FALSE;
@@ -265,12 +864,12 @@ static gboolean restart_input_pipeline(gpointer data) {
 
 static void on_bus_warning(GstBus *bus, GstMessage *msg, gpointer data) {
     (void)bus;
-    const char *pipeline_name = (const char *)data;
+    BusContext *ctx = (BusContext *)data;
     GError *err = NULL;
     gchar *debug = NULL;
 
     gst_message_parse_warning(msg, &err, &debug);
-    g_print("[FrameBuffer] %s WARNING: %s\n", pipeline_name, err->message);
+    fb_log(ctx->fb, "%s WARNING: %s\n", ctx->pipeline_name, err->message);
     g_error_free(err);
     g_free(debug);
 }
@@ -278,25 +877,54 @@ static void on_bus_warning(GstBus *bus, GstMessage *msg, gpointer data) {
 static void on_bus_eos(GstBus *bus, GstMessage *msg, gpointer data) {
     (void)bus;
     (void)msg;
-    const char *pipeline_name = (const char *)data;
-    g_print("[FrameBuffer] %s: End of stream\n", pipeline_name);
+    BusContext *ctx = (BusContext *)data;
+    fb_log(ctx->fb, "%s: End of stream\n", ctx->pipeline_name);
 }
 
 /* ========== Initialize FrameBuffer with Defaults ========== */
 static FrameBuffer *framebuffer_new(void) {
-    FrameBuffer *fb = g_new0(FrameBuffer, 1);
-    g_mutex_init(&fb->frame_mutex);
+    /* The stats blocks are aligned(64); plain malloc only guarantees 16,
+     * which would silently void the per-cache-line layout (and is UB for
+     * an over-aligned type). g_aligned_alloc is GLib 2.72+, same era as
+     * the GStreamer 1.20 floor. Freed with g_aligned_free(). */
+    FrameBuffer *fb = g_aligned_alloc0(1, sizeof(FrameBuffer), 64);
+    fb->log_name = g_strdup("FrameBuffer");
+    fb->input_bus_ctx.fb = fb;
+    fb->input_bus_ctx.pipeline_name = "INPUT";
+    fb->output_bus_ctx.fb = fb;
+    fb->output_bus_ctx.pipeline_name = "OUTPUT";
+    fb->encode_bus_ctx.fb = fb;
+    fb->encode_bus_ctx.pipeline_name = "ENCODE";
+    fb->backup_bus_ctx.fb = fb;
+    fb->backup_bus_ctx.pipeline_name = "BACKUP";
+    fb->standby_bus_ctx.fb = fb;
+    fb->standby_bus_ctx.pipeline_name = "STANDBY";
+    fb->active_input = INPUT_PRIMARY;
     fb->running = FALSE;
-    fb->current_frame = NULL;
+
+    /* Triple buffer: producer and consumer each start with a private slot,
+     * the third sits in the pending mailbox (all empty until first frame) */
+    fb->input_slot = &fb->slots[0];
+    fb->output_slot = &fb->slots[1];
+    fb->pending_slot = &fb->slots[2];
+    fb->frame_available = 0;
+
     fb->current_caps = NULL;
     fb->fallback_frame = NULL;      /* Created after we know dimensions */
-    fb->last_input_time = 0;        /* No input yet */
 
     /* Input defaults */
     fb->input_port = DEFAULT_INPUT_PORT;
     fb->udp_buffer_size = DEFAULT_UDP_BUFFER_SIZE;
     fb->jitter_buffer_ms = DEFAULT_JITTER_BUFFER_MS;
     fb->max_queue_time_ms = DEFAULT_MAX_QUEUE_TIME_MS;
+    fb->input_accel = ACCEL_NONE;
+    fb->accel_resolved = FALSE;
+    fb->accel_chain = NULL;
+    fb->stall_timeout_ms = DEFAULT_STALL_TIMEOUT_MS;
+    fb->jitter_adaptive = FALSE;
+    fb->jitter_min_ms = DEFAULT_JITTER_MIN_MS;
+    fb->jitter_max_ms = DEFAULT_JITTER_MAX_MS;
+    fb->jitter_current_ms = DEFAULT_JITTER_BUFFER_MS;
 
     /* Output defaults */
     fb->output_port = DEFAULT_OUTPUT_PORT;
@@ -310,6 +938,9 @@ static FrameBuffer *framebuffer_new(void) {
     /* Output format defaults */
     fb->codec = CODEC_H264;
     fb->container = CONTAINER_MPEGTS;
+    fb->hw = HW_NONE;
+    fb->hw_factory = NULL;
+    fb->repeat_cache = FALSE;
 
     /* Shared memory */
     fb->shm_path = g_strdup(DEFAULT_SHM_PATH);
@@ -320,6 +951,7 @@ static FrameBuffer *framebuffer_new(void) {
 
     /* Stats */
     fb->stats_interval = DEFAULT_STATS_INTERVAL_SEC;
+    fb->preview_fps = 2;
 
     /* Verbose */
     fb->verbose = FALSE;
@@ -327,332 +959,1631 @@ static FrameBuffer *framebuffer_new(void) {
     return fb;
 }
 
-/* ========== Create Input Pipeline ========== */
-static gboolean create_input_pipeline(FrameBuffer *fb) {
-    GError *error = NULL;
+/* ========== Input Acceleration (GPU convert/scale) ========== */
 
-    guint64 jitter_ns = fb->jitter_buffer_ms * 1000000ULL;
-    guint64 max_time_ns = fb->max_queue_time_ms * 1000000ULL;
+static const char *accel_to_string(InputAccel accel) {
+    switch (accel) {
+        case ACCEL_NONE:  return "none";
+        case ACCEL_AUTO:  return "auto";
+        case ACCEL_GL:    return "gl";
+        case ACCEL_VAAPI: return "vaapi";
+        default:          return "unknown";
+    }
+}
 
-    gchar *pipeline_str = g_strdup_printf(
-        "udpsrc port=%d buffer-size=%" G_GUINT64_FORMAT " "
-        "caps=\"video/mpegts,systemstream=true\" name=udpsrc "
-        "! queue min-threshold-time=%" G_GUINT64_FORMAT " "
-        "max-size-buffers=0 max-size-bytes=0 max-size-time=%" G_GUINT64_FORMAT " "
-        "! tsparse "
-        "! decodebin3 "
-        "! videoconvert "
-        "! videoscale add-borders=true "
-        "! video/x-raw,format=I420,width=%d,height=%d "
-        "! appsink name=sink emit-signals=true sync=false max-buffers=%d drop=true",
-        fb->input_port,
-        fb->udp_buffer_size,
-        jitter_ns,
-        max_time_ns,
-        fb->width,
-        fb->height,
-        fb->appsink_max_buffers
-    );
+static InputAccel string_to_accel(const char *str) {
+    if (strcasecmp(str, "auto") == 0) return ACCEL_AUTO;
+    if (strcasecmp(str, "gl") == 0) return ACCEL_GL;
+    if (strcasecmp(str, "vaapi") == 0) return ACCEL_VAAPI;
+    return ACCEL_NONE;
+}
 
-    if (fb->verbose) {
-        g_print("[FrameBuffer] Input pipeline: %s\n", pipeline_str);
-    }
+/* The GL chain needs all four elements; probe them as a unit */
+static gboolean gl_chain_exists(void) {
+    return element_exists("glupload") && element_exists("glcolorconvert") &&
+           element_exists("glcolorscale") && element_exists("gldownload");
+}
 
-    fb->input_pipeline = gst_parse_launch(pipeline_str, &error);
-    g_free(pipeline_str);
+/**
+ * Resolve the requested input acceleration against the plugin registry.
+ * Idempotent - the input pipeline rebuilds on auto-restart and we don't
+ * want to re-probe (or re-log) every time. The chain keeps the same
+ * I420 system-memory appsink contract as the software path.
+ */
+static void resolve_input_accel(FrameBuffer *fb) {
+    if (fb->accel_resolved) return;
+    fb->accel_resolved = TRUE;
+
+    if (fb->input_accel == ACCEL_AUTO || fb->input_accel == ACCEL_VAAPI) {
+        /* Prefer the new "va" plugin; vapostproc scales and converts in one
+         * element and supports add-borders like videoscale does */
+        if (element_exists("vapostproc")) {
+            fb->input_accel = ACCEL_VAAPI;
+            fb->accel_chain = "vapostproc name=conv add-borders=true";
+        } else if (element_exists("vaapipostproc")) {
+            fb->input_accel = ACCEL_VAAPI;
+            fb->accel_chain = "vaapipostproc name=conv";
+            /* Unlike videoscale/vapostproc there is no add-borders here */
+            fb_log(fb, "vaapipostproc has no letterboxing: aspect-mismatched "
+                    "sources will be stretched, not bordered\n");
+        } else if (fb->input_accel == ACCEL_VAAPI) {
+            fb_logerr(fb, "VAAPI postproc not available, using software convert/scale\n");
+            fb->input_accel = ACCEL_NONE;
+            return;
+        }
+    }
 
-    if (error) {
-        g_printerr("[FrameBuffer] Failed to create input pipeline: %s\n", error->message);
-        g_error_free(error);
-        return FALSE;
+    if (fb->input_accel == ACCEL_AUTO || fb->input_accel == ACCEL_GL) {
+        if (gl_chain_exists()) {
+            fb->input_accel = ACCEL_GL;
+            fb->accel_chain = "glupload name=conv ! glcolorconvert ! glcolorscale ! gldownload";
+            /* glcolorscale scales to the target caps without borders */
+            fb_log(fb, "GL convert/scale has no letterboxing: aspect-mismatched "
+                    "sources will be stretched, not bordered\n");
+        } else if (fb->input_accel == ACCEL_GL) {
+            fb_logerr(fb, "GL elements not available, using software convert/scale\n");
+            fb->input_accel = ACCEL_NONE;
+            return;
+        } else {
+            /* auto: nothing found */
+            fb_log(fb, "No GPU convert/scale found, using software\n");
+            fb->input_accel = ACCEL_NONE;
+            return;
+        }
     }
 
-    fb->appsink = gst_bin_get_by_name(GST_BIN(fb->input_pipeline), "sink");
-    if (!fb->appsink) {
-        g_printerr("[FrameBuffer] Failed to get appsink\n");
-        return FALSE;
+    if (fb->input_accel != ACCEL_NONE) {
+        fb_log(fb, "Input convert/scale: %s (%s)\n",
+                fb->accel_chain, accel_to_string(fb->input_accel));
     }
+}
 
-    g_signal_connect(fb->appsink, "new-sample", G_CALLBACK(on_new_sample), fb);
+/* ========== Batched UDP Receive (recvmmsg) ========== */
 
-    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(fb->input_pipeline));
-    gst_bus_add_signal_watch(bus);
-    g_signal_connect(bus, "message::error", G_CALLBACK(on_bus_error), (gpointer)"INPUT");
-    g_signal_connect(bus, "message::warning", G_CALLBACK(on_bus_warning), (gpointer)"INPUT");
-    g_signal_connect(bus, "message::eos", G_CALLBACK(on_bus_eos), (gpointer)"INPUT");
-    gst_object_unref(bus);
+static InputEngine string_to_engine(const char *str) {
+    if (strcasecmp(str, "batched") == 0) return ENGINE_BATCHED;
+    return ENGINE_STOCK;
+}
 
-    g_print("[FrameBuffer] Input: UDP port %d, %" G_GUINT64_FORMAT "ms jitter buffer\n",
-            fb->input_port, fb->jitter_buffer_ms);
-    return TRUE;
+static InputProto string_to_proto(const char *str) {
+    if (strcasecmp(str, "srt") == 0) return PROTO_SRT;
+    if (strcasecmp(str, "rist") == 0) return PROTO_RIST;
+    return PROTO_UDP;
 }
 
-/* ========== Build Encoder String ========== */
-static gchar *build_encoder_string(FrameBuffer *fb) {
-    switch (fb->codec) {
-        case CODEC_RAW:
-            return g_strdup("");  /* No encoder */
+static const char *proto_to_string(InputProto proto) {
+    switch (proto) {
+        case PROTO_SRT:  return "srt";
+        case PROTO_RIST: return "rist";
+        default:         return "udp";
+    }
+}
 
-        case CODEC_H264:
-            return g_strdup_printf(
-                "videoconvert ! x264enc tune=%s speed-preset=%s bitrate=%d key-int-max=%d ! h264parse ",
-                DEFAULT_X264_TUNE, DEFAULT_X264_PRESET,
-                fb->bitrate, fb->keyframe_interval
-            );
+#ifdef __linux__
 
-        case CODEC_H265:
-            return g_strdup_printf(
-                "videoconvert ! x265enc tune=%s speed-preset=%s bitrate=%d key-int-max=%d ! h265parse ",
-                DEFAULT_X265_TUNE, DEFAULT_X265_PRESET,
-                fb->bitrate, fb->keyframe_interval
-            );
+#define RECV_BATCH     32
+#define RECV_SLOT_SIZE 2048   /* > any sane TS datagram (7*188 plus headroom) */
 
-        case CODEC_VP8:
-            return g_strdup_printf(
-                "videoconvert ! vp8enc deadline=%d cpu-used=%d target-bitrate=%d000 keyframe-max-dist=%d ",
-                DEFAULT_VP8_DEADLINE, DEFAULT_VP8_CPU_USED,
-                fb->bitrate, fb->keyframe_interval
-            );
+/**
+ * Receive thread for --input-engine batched: pulls up to RECV_BATCH
+ * datagrams per recvmmsg syscall into a pre-allocated ring and pushes
+ * them to the "netsrc" appsrc. At 50 Mbps the stock udpsrc costs one
+ * syscall per 1316-byte datagram; this brings kernel time down by the
+ * batch factor.
+ */
+static gpointer recv_loop(gpointer data) {
+    FrameBuffer *fb = (FrameBuffer *)data;
 
-        case CODEC_VP9:
-            return g_strdup_printf(
-                "videoconvert ! vp9enc deadline=%d cpu-used=%d target-bitrate=%d000 keyframe-max-dist=%d ",
-                DEFAULT_VP9_DEADLINE, DEFAULT_VP9_CPU_USED,
-                fb->bitrate, fb->keyframe_interval
-            );
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        fb_logerr(fb, "Batched receive: socket failed: %s\n", g_strerror(errno));
+        return NULL;
+    }
 
-        default:
-            return g_strdup("");
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    int rcvbuf = (int)fb->udp_buffer_size;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    /* Bounded block so the loop notices recv_running going FALSE */
+    struct timeval rcv_timeout = { 1, 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &rcv_timeout, sizeof(rcv_timeout));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((guint16)fb->input_port);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fb_logerr(fb, "Batched receive: bind to port %d failed: %s\n",
+                  fb->input_port, g_strerror(errno));
+        close(sock);
+        return NULL;
     }
-}
 
-/* ========== Build Muxer/Payloader String ========== */
-/* NOTE: All strings start with "! " to properly link after encoder */
-static gchar *build_muxer_string(FrameBuffer *fb) {
-    switch (fb->container) {
-        case CONTAINER_SHM:
-            return g_strdup_printf(
-                "! shmsink socket-path=%s shm-size=%" G_GUINT64_FORMAT " wait-for-connection=false sync=false",
-                fb->shm_path, fb->shm_size
-            );
+    /* Pre-allocated receive ring: one contiguous region, fixed iovecs */
+    guint8 *ring = g_malloc((gsize)RECV_BATCH * RECV_SLOT_SIZE);
+    struct mmsghdr msgs[RECV_BATCH];
+    struct iovec iovs[RECV_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < RECV_BATCH; i++) {
+        iovs[i].iov_base = ring + (gsize)i * RECV_SLOT_SIZE;
+        iovs[i].iov_len = RECV_SLOT_SIZE;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
 
-        case CONTAINER_MPEGTS:
-            return g_strdup_printf(
-                "! mpegtsmux ! udpsink host=%s port=%d sync=false",
-                fb->output_host, fb->output_port
-            );
+    fb_log(fb, "Batched receive started (port %d, batch %d)\n",
+            fb->input_port, RECV_BATCH);
 
-        case CONTAINER_RAW_UDP:
-            return g_strdup_printf(
-                "! udpsink host=%s port=%d sync=false",
-                fb->output_host, fb->output_port
-            );
+    while (fb->recv_running) {
+        int n = recvmmsg(sock, msgs, RECV_BATCH, MSG_WAITFORONE, NULL);
+        if (n <= 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+            fb_logerr(fb, "recvmmsg failed: %s\n", g_strerror(errno));
+            break;
+        }
 
-        case CONTAINER_FILE:
-            /* File muxer based on codec */
-            if (fb->codec == CODEC_RAW) {
-                return g_strdup_printf(
-                    "! avimux ! filesink location=%s",
-                    fb->output_file ? fb->output_file : "output.avi"
-                );
-            } else if (fb->codec == CODEC_VP8 || fb->codec == CODEC_VP9) {
-                return g_strdup_printf(
-                    "! matroskamux ! filesink location=%s",
-                    fb->output_file ? fb->output_file : "output.mkv"
-                );
-            } else {
-                /* H.264, H.265 -> MP4 */
-                return g_strdup_printf(
-                    "! mp4mux ! filesink location=%s",
-                    fb->output_file ? fb->output_file : "output.mp4"
-                );
-            }
+        gsize total = 0;
+        for (int i = 0; i < n; i++) total += msgs[i].msg_len;
+        if (total == 0) continue;
+
+        /* Compact the batch into one buffer: tsparse accepts arbitrary
+         * chunking, and one push per batch amortizes the appsrc overhead.
+         * The copy is trivial next to the syscalls it replaces. */
+        GstBuffer *buf = gst_buffer_new_allocate(NULL, total, NULL);
+        STAT_FETCH_ADD(fb->frame_path_allocs, 1);
+        GstMapInfo map;
+        gst_buffer_map(buf, &map, GST_MAP_WRITE);
+        gsize off = 0;
+        for (int i = 0; i < n; i++) {
+            memcpy(map.data + off, iovs[i].iov_base, msgs[i].msg_len);
+            off += msgs[i].msg_len;
+        }
+        gst_buffer_unmap(buf, &map);
 
-        case CONTAINER_RTP:
-        default:
-            /* RTP payloader depends on codec */
-            switch (fb->codec) {
-                case CODEC_RAW:
-                    return g_strdup_printf(
-                        "! rtpvrawpay mtu=%d ! udpsink host=%s port=%d sync=false",
-                        DEFAULT_RTP_MTU, fb->output_host, fb->output_port
-                    );
-                case CODEC_H264:
-                    return g_strdup_printf(
-                        "! rtph264pay config-interval=1 mtu=%d ! udpsink host=%s port=%d sync=false",
-                        DEFAULT_RTP_MTU, fb->output_host, fb->output_port
-                    );
-                case CODEC_H265:
-                    return g_strdup_printf(
-                        "! rtph265pay config-interval=1 mtu=%d ! udpsink host=%s port=%d sync=false",
-                        DEFAULT_RTP_MTU, fb->output_host, fb->output_port
-                    );
-                case CODEC_VP8:
-                    return g_strdup_printf(
-                        "! rtpvp8pay mtu=%d ! udpsink host=%s port=%d sync=false",
-                        DEFAULT_RTP_MTU, fb->output_host, fb->output_port
-                    );
-                case CODEC_VP9:
-                    return g_strdup_printf(
-                        "! rtpvp9pay mtu=%d ! udpsink host=%s port=%d sync=false",
-                        DEFAULT_RTP_MTU, fb->output_host, fb->output_port
-                    );
-                default:
-                    return g_strdup_printf(
-                        "! udpsink host=%s port=%d sync=false",
-                        fb->output_host, fb->output_port
-                    );
-            }
+        GstFlowReturn ret = gst_app_src_push_buffer(GST_APP_SRC(fb->net_appsrc), buf);
+        if (ret == GST_FLOW_FLUSHING || ret == GST_FLOW_EOS) break;
     }
+
+    g_free(ring);
+    close(sock);
+    fb_log(fb, "Batched receive stopped\n");
+    return NULL;
 }
 
-/* ========== Create Output Pipeline ========== */
-static gboolean create_output_pipeline(FrameBuffer *fb) {
-    gchar *caps_str = g_strdup_printf(
-        "video/x-raw,format=I420,width=%d,height=%d,framerate=%d/1",
-        fb->width, fb->height, fb->fps
-    );
+#endif /* __linux__ */
 
-    gchar *encoder_str = build_encoder_string(fb);
-    gchar *muxer_str = build_muxer_string(fb);
+static void start_recv_thread(FrameBuffer *fb) {
+#ifdef __linux__
+    if (fb->input_engine != ENGINE_BATCHED || fb->recv_thread || fb->bench) return;
+    fb->recv_running = TRUE;
+    fb->recv_thread = g_thread_new("udp-recv", recv_loop, fb);
+#else
+    (void)fb;
+#endif
+}
 
-    /* For SHM output with encoded video, we need different handling */
-    gboolean shm_with_encoding = (fb->container == CONTAINER_SHM && fb->codec != CODEC_RAW);
+static void stop_recv_thread(FrameBuffer *fb) {
+    if (!fb->recv_thread) return;
+    fb->recv_running = FALSE;
+    g_thread_join(fb->recv_thread);
+    fb->recv_thread = NULL;
+}
+
+/* ========== Create Input Pipeline ========== */
+
+/* Shared by the live input pipeline and the warm standby: validations,
+ * acceleration probe and the full gst-launch string. Returns NULL when a
+ * required transport plugin is missing. */
+static gchar *build_input_pipeline_string(FrameBuffer *fb) {
+    validate_passthrough(fb);
+    validate_audio(fb);
+
+#ifndef __linux__
+    if (fb->input_engine == ENGINE_BATCHED) {
+        fb_log(fb, "Batched input engine requires Linux (recvmmsg), using stock udpsrc\n");
+        fb->input_engine = ENGINE_STOCK;
+    }
+#endif
+
+    if (fb->input_proto != PROTO_UDP && !fb->bench) {
+        /* Missing transport plugins mean no ingestion at all - fail loudly
+         * instead of silently switching protocol on the sender */
+        const char *proto_factory = (fb->input_proto == PROTO_SRT) ? "srtsrc" : "ristsrc";
+        if (!element_exists(proto_factory)) {
+            fb_logerr(fb, "%s not found - install the gst-plugins-bad %s plugin\n",
+                      proto_factory, proto_to_string(fb->input_proto));
+            return NULL;
+        }
+        if (fb->input_engine == ENGINE_BATCHED) {
+            fb_log(fb, "Batched engine applies to udp input only, using %s directly\n",
+                    proto_factory);
+            fb->input_engine = ENGINE_STOCK;
+        }
+    }
+
+    resolve_input_accel(fb);
+
+    /* SRT/RIST map jitter_buffer_ms onto their retransmission window, which
+     * REPLACES the queue threshold - stacking both would double the latency.
+     * In adaptive mode the current (adapted) value survives input restarts. */
+    guint64 jitter_ms = fb->jitter_adaptive ? fb->jitter_current_ms
+                                            : fb->jitter_buffer_ms;
+    guint64 jitter_ns = (fb->input_proto == PROTO_UDP)
+        ? jitter_ms * 1000000ULL
+        : 0;
+    guint64 max_time_ns = fb->max_queue_time_ms * 1000000ULL;
+
+    /* GPU or software colorspace conversion + scaling; both end in the same
+     * I420 system-memory caps so the appsink contract never changes */
+    const char *convert_chain = fb->accel_chain
+        ? fb->accel_chain
+        : "videoconvert name=conv ! videoscale add-borders=true";
+
+    gchar *pipeline_str;
+    if (fb->bench) {
+        /* Benchmark mode: synthetic timestamped source instead of udpsrc,
+         * exercising the frame slot, render loop and encoder without
+         * external senders/receivers */
+        pipeline_str = g_strdup_printf(
+            "videotestsrc is-live=true pattern=smpte "
+            "! video/x-raw,format=I420,width=%d,height=%d,framerate=%d/1 "
+            "! appsink name=sink emit-signals=true sync=false max-buffers=%d drop=true",
+            fb->width,
+            fb->height,
+            fb->fps,
+            fb->appsink_max_buffers
+        );
+    } else {
+        /* Network front-end: stock udpsrc, or the recvmmsg appsrc feeding
+         * the identical downstream chain */
+        gchar *src_str;
+        if (fb->input_proto == PROTO_SRT) {
+            src_str = g_strdup_printf(
+                "srtsrc uri=\"srt://0.0.0.0:%d?mode=listener\" latency=%d "
+                "wait-for-connection=false",
+                fb->input_port, (gint)fb->jitter_buffer_ms);
+        } else if (fb->input_proto == PROTO_RIST) {
+            src_str = g_strdup_printf(
+                "ristsrc address=0.0.0.0 port=%d receiver-buffer=%d",
+                fb->input_port, (gint)fb->jitter_buffer_ms);
+        } else if (fb->input_engine == ENGINE_BATCHED) {
+            src_str = g_strdup(
+                "appsrc name=netsrc is-live=true do-timestamp=true format=time "
+                "caps=\"video/mpegts,systemstream=true\"");
+        } else {
+            src_str = g_strdup_printf(
+                "udpsrc port=%d buffer-size=%" G_GUINT64_FORMAT " "
+                "caps=\"video/mpegts,systemstream=true\" name=udpsrc",
+                fb->input_port,
+                fb->udp_buffer_size);
+        }
+
+        if (fb->passthrough) {
+            /* Compressed-domain tap: parsed access units, no decoder.
+             * drop is off (every delta matters); backlog control lives in
+             * passthrough_tick(). */
+            pipeline_str = g_strdup_printf(
+                "%s "
+                "! queue name=jbuf min-threshold-time=%" G_GUINT64_FORMAT " "
+                "max-size-buffers=0 max-size-bytes=0 max-size-time=%" G_GUINT64_FORMAT " "
+                "! tsparse name=tsp "
+                "! tsdemux "
+                "! h264parse config-interval=-1 "
+                "! video/x-h264,stream-format=byte-stream,alignment=au "
+                "! appsink name=sink emit-signals=true sync=false max-buffers=8",
+                src_str,
+                jitter_ns,
+                max_time_ns
+            );
+        } else {
+            pipeline_str = g_strdup_printf(
+                "%s "
+                "! queue name=jbuf min-threshold-time=%" G_GUINT64_FORMAT " "
+                "max-size-buffers=0 max-size-bytes=0 max-size-time=%" G_GUINT64_FORMAT " "
+                "! tsparse name=tsp "
+                "! decodebin3 name=dec "
+                "! %s "
+                "! video/x-raw,format=I420,width=%d,height=%d "
+                "! appsink name=sink emit-signals=true sync=false max-buffers=%d drop=true",
+                src_str,
+                jitter_ns,
+                max_time_ns,
+                convert_chain,
+                fb->width,
+                fb->height,
+                fb->appsink_max_buffers
+            );
+        }
+        g_free(src_str);
+    }
+
+    /* Parallel audio branch off decodebin3 (validated: decode path only).
+     * If the source carries no audio the branch simply never sees data;
+     * audio_tick() silence-fills the output. */
+    if (fb->audio_enable) {
+        gchar *with_audio = g_strdup_printf(
+            "%s dec. ! queue ! audioconvert ! audioresample "
+            "! audio/x-raw,format=S16LE,layout=interleaved,rate=%d,channels=%d "
+            "! appsink name=asink emit-signals=true sync=false max-buffers=32",
+            pipeline_str, AUDIO_RATE, AUDIO_CHANNELS);
+        g_free(pipeline_str);
+        pipeline_str = with_audio;
+    }
+
+    return pipeline_str;
+}
+
+/**
+ * Build the warm standby: parse cost and plugin loading are paid now, while
+ * the live pipeline is healthy. READY keeps sockets unbound (udpsrc binds
+ * on READY->PAUSED), so it doesn't compete with the live input for the port.
+ */
+static gboolean create_standby_input_pipeline(FrameBuffer *fb) {
+    GError *error = NULL;
+
+    gchar *pipeline_str = build_input_pipeline_string(fb);
+    if (!pipeline_str) {
+        return FALSE;
+    }
+
+    fb->standby_pipeline = gst_parse_launch(pipeline_str, &error);
+    g_free(pipeline_str);
+
+    if (error) {
+        fb_logerr(fb, "Failed to build standby pipeline: %s\n", error->message);
+        g_error_free(error);
+        fb->standby_pipeline = NULL;
+        return FALSE;
+    }
+
+    fb->standby_appsink = gst_bin_get_by_name(GST_BIN(fb->standby_pipeline), "sink");
+    g_signal_connect(fb->standby_appsink, "new-sample",
+                     fb->passthrough ? G_CALLBACK(on_passthrough_sample)
+                                     : G_CALLBACK(on_new_sample), fb);
+
+    if (fb->audio_enable) {
+        GstElement *asink = gst_bin_get_by_name(GST_BIN(fb->standby_pipeline), "asink");
+        if (asink) {
+            g_signal_connect(asink, "new-sample", G_CALLBACK(on_audio_sample), fb);
+            gst_object_unref(asink);
+        }
+    }
+
+    /* Dedicated context: a standby error must never look like a live-input
+     * error, or recovery would tear down the healthy input (and possibly
+     * promote the very pipeline that just errored) */
+    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(fb->standby_pipeline));
+    gst_bus_add_signal_watch(bus);
+    g_signal_connect(bus, "message::error", G_CALLBACK(on_bus_error), &fb->standby_bus_ctx);
+    g_signal_connect(bus, "message::warning", G_CALLBACK(on_bus_warning), &fb->standby_bus_ctx);
+    g_signal_connect(bus, "message::eos", G_CALLBACK(on_bus_eos), &fb->standby_bus_ctx);
+    gst_object_unref(bus);
+
+    gst_element_set_state(fb->standby_pipeline, GST_STATE_READY);
+    fb_log(fb, "Warm standby input pipeline built (READY)\n");
+    return TRUE;
+}
+
+static gboolean build_standby_idle(gpointer data) {
+    FrameBuffer *fb = (FrameBuffer *)data;
+    fb->standby_build_id = 0;
+    create_standby_input_pipeline(fb);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean create_input_pipeline(FrameBuffer *fb) {
+    GError *error = NULL;
+
+    gchar *pipeline_str = build_input_pipeline_string(fb);
+    if (!pipeline_str) {
+        return FALSE;
+    }
+
+    if (fb->verbose) {
+        fb_log(fb, "Input pipeline: %s\n", pipeline_str);
+    }
+
+    fb->input_pipeline = gst_parse_launch(pipeline_str, &error);
+    g_free(pipeline_str);
+
+    if (error) {
+        fb_logerr(fb, "Failed to create input pipeline: %s\n", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    fb->appsink = gst_bin_get_by_name(GST_BIN(fb->input_pipeline), "sink");
+    if (!fb->appsink) {
+        fb_logerr(fb, "Failed to get appsink\n");
+        return FALSE;
+    }
+
+    if (fb->input_engine == ENGINE_BATCHED && !fb->bench) {
+        fb->net_appsrc = gst_bin_get_by_name(GST_BIN(fb->input_pipeline), "netsrc");
+    }
+
+    g_signal_connect(fb->appsink, "new-sample",
+                     fb->passthrough ? G_CALLBACK(on_passthrough_sample)
+                                     : G_CALLBACK(on_new_sample), fb);
+
+    if (fb->audio_enable) {
+        fb->audio_appsink = gst_bin_get_by_name(GST_BIN(fb->input_pipeline), "asink");
+        if (fb->audio_appsink) {
+            g_signal_connect(fb->audio_appsink, "new-sample",
+                             G_CALLBACK(on_audio_sample), fb);
+        }
+    }
+
+    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(fb->input_pipeline));
+    gst_bus_add_signal_watch(bus);
+    g_signal_connect(bus, "message::error", G_CALLBACK(on_bus_error), &fb->input_bus_ctx);
+    g_signal_connect(bus, "message::warning", G_CALLBACK(on_bus_warning), &fb->input_bus_ctx);
+    g_signal_connect(bus, "message::eos", G_CALLBACK(on_bus_eos), &fb->input_bus_ctx);
+    gst_object_unref(bus);
+
+    if (fb->backup_port > 0 && !fb->bench && !fb->backup_pipeline) {
+        /* Guarded so auto-restart of the primary never rebuilds the backup */
+        if (!create_backup_pipeline(fb)) {
+            return FALSE;
+        }
+    }
+
+    if (fb->bench) {
+        fb_log(fb, "Input: synthetic %dx%d @ %dfps (benchmark)\n",
+                fb->width, fb->height, fb->fps);
+    } else if (fb->input_proto != PROTO_UDP) {
+        fb_log(fb, "Input: %s port %d, %" G_GUINT64_FORMAT "ms retransmission buffer\n",
+                proto_to_string(fb->input_proto), fb->input_port, fb->jitter_buffer_ms);
+    } else {
+        fb_log(fb, "Input: UDP port %d, %" G_GUINT64_FORMAT "ms jitter buffer%s\n",
+                fb->input_port, fb->jitter_buffer_ms,
+                (fb->input_engine == ENGINE_BATCHED) ? " (batched recvmmsg)" : "");
+    }
+    return TRUE;
+}
+
+/* ========== Hardware Encoder Resolution ========== */
+
+/* Map codec+backend to a concrete encoder factory present in the registry,
+ * or NULL if that backend is unavailable on this machine */
+static const char *hw_encoder_factory(OutputCodec codec, HwBackend hw) {
+    if (codec == CODEC_H264) {
+        switch (hw) {
+            case HW_VAAPI:
+                /* Prefer the new "va" plugin, fall back to gstreamer-vaapi */
+                if (element_exists("vah264enc")) return "vah264enc";
+                if (element_exists("vaapih264enc")) return "vaapih264enc";
+                return NULL;
+            case HW_NVENC:
+                return element_exists("nvh264enc") ? "nvh264enc" : NULL;
+            case HW_V4L2:
+                return element_exists("v4l2h264enc") ? "v4l2h264enc" : NULL;
+            default:
+                return NULL;
+        }
+    }
+    if (codec == CODEC_H265) {
+        switch (hw) {
+            case HW_VAAPI:
+                if (element_exists("vah265enc")) return "vah265enc";
+                if (element_exists("vaapih265enc")) return "vaapih265enc";
+                return NULL;
+            case HW_NVENC:
+                return element_exists("nvh265enc") ? "nvh265enc" : NULL;
+            case HW_V4L2:
+                return element_exists("v4l2h265enc") ? "v4l2h265enc" : NULL;
+            default:
+                return NULL;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Resolve the requested hardware backend against the plugin registry.
+ * HW_AUTO probes VAAPI -> NVENC -> V4L2; anything unavailable falls back
+ * to the software encoders so a config written for a GPU box still runs
+ * (degraded, but running) on a CPU-only one.
+ */
+static void resolve_hw_backend(FrameBuffer *fb) {
+    if (fb->hw == HW_NONE) return;
+
+    if (fb->codec != CODEC_H264 && fb->codec != CODEC_H265) {
+        fb_log(fb, "Hardware encoding only supported for h264/h265, using software %s\n",
+                codec_to_string(fb->codec));
+        fb->hw = HW_NONE;
+        return;
+    }
+
+    if (fb->hw == HW_AUTO) {
+        static const HwBackend probe_order[] = { HW_VAAPI, HW_NVENC, HW_V4L2 };
+        for (gsize i = 0; i < sizeof(probe_order) / sizeof(probe_order[0]); i++) {
+            const char *factory = hw_encoder_factory(fb->codec, probe_order[i]);
+            if (factory) {
+                fb->hw = probe_order[i];
+                fb->hw_factory = factory;
+                fb_log(fb, "Hardware encoder: %s (%s, auto-detected)\n",
+                        factory, hw_to_string(fb->hw));
+                return;
+            }
+        }
+        fb_log(fb, "No hardware encoder found, using software %s\n",
+                codec_to_string(fb->codec));
+        fb->hw = HW_NONE;
+        return;
+    }
+
+    fb->hw_factory = hw_encoder_factory(fb->codec, fb->hw);
+    if (!fb->hw_factory) {
+        fb_logerr(fb, "Requested %s encoder for %s not available, using software\n",
+                   hw_to_string(fb->hw), codec_to_string(fb->codec));
+        fb->hw = HW_NONE;
+        return;
+    }
+    fb_log(fb, "Hardware encoder: %s (%s)\n", fb->hw_factory, hw_to_string(fb->hw));
+}
+
+/* ========== Build Encoder String ========== */
+
+/* Hardware encoder branch: property names differ per plugin family.
+ * videoconvert in front keeps the system-memory I420 contract from appsrc;
+ * the va/nv encoders upload internally. */
+static gchar *build_hw_encoder_string(FrameBuffer *fb) {
+    const char *parse = (fb->codec == CODEC_H265) ? "h265parse" : "h264parse";
+    const char *factory = fb->hw_factory;
+
+    if (strncmp(factory, "va", 2) == 0 && strncmp(factory, "vaapi", 5) != 0) {
+        /* New-style va plugin (vah264enc/vah265enc) */
+        return g_strdup_printf(
+            "videoconvert ! %s name=enc bitrate=%d key-int-max=%d ! %s ",
+            factory, fb->bitrate, fb->keyframe_interval, parse);
+    }
+    if (strncmp(factory, "vaapi", 5) == 0) {
+        return g_strdup_printf(
+            "videoconvert ! %s name=enc rate-control=cbr bitrate=%d keyframe-period=%d ! %s ",
+            factory, fb->bitrate, fb->keyframe_interval, parse);
+    }
+    if (strncmp(factory, "nv", 2) == 0) {
+        /* nvh26xenc take bitrate in kbps; low-latency preset matches the
+         * zerolatency tune used on the software path */
+        return g_strdup_printf(
+            "videoconvert ! %s name=enc preset=low-latency-hq rc-mode=cbr bitrate=%d gop-size=%d ! %s ",
+            factory, fb->bitrate, fb->keyframe_interval, parse);
+    }
+    if (strncmp(factory, "v4l2", 4) == 0) {
+        /* V4L2 stateful encoders configure via extra-controls (bitrate in bps) */
+        return g_strdup_printf(
+            "videoconvert ! %s name=enc extra-controls=\"controls,video_bitrate=%d000,video_gop_size=%d\" ! %s ",
+            factory, fb->bitrate, fb->keyframe_interval, parse);
+    }
+
+    fb_logerr(fb, "Unknown hardware encoder factory %s\n", factory);
+    return NULL;
+}
+
+static gchar *build_encoder_string(FrameBuffer *fb) {
+    if (fb->hw != HW_NONE && fb->hw_factory) {
+        gchar *hw_str = build_hw_encoder_string(fb);
+        if (hw_str) return hw_str;
+        /* Fall through to software on unexpected factory */
+    }
+    switch (fb->codec) {
+        case CODEC_RAW:
+            return g_strdup("");  /* No encoder */
+
+        case CODEC_H264:
+            return g_strdup_printf(
+                "videoconvert ! x264enc name=enc tune=%s speed-preset=%s bitrate=%d key-int-max=%d ! h264parse ",
+                DEFAULT_X264_TUNE, DEFAULT_X264_PRESET,
+                fb->bitrate, fb->keyframe_interval
+            );
+
+        case CODEC_H265:
+            return g_strdup_printf(
+                "videoconvert ! x265enc name=enc tune=%s speed-preset=%s bitrate=%d key-int-max=%d ! h265parse ",
+                DEFAULT_X265_TUNE, DEFAULT_X265_PRESET,
+                fb->bitrate, fb->keyframe_interval
+            );
+
+        case CODEC_VP8:
+            return g_strdup_printf(
+                "videoconvert ! vp8enc name=enc deadline=%d cpu-used=%d target-bitrate=%d000 keyframe-max-dist=%d ",
+                DEFAULT_VP8_DEADLINE, DEFAULT_VP8_CPU_USED,
+                fb->bitrate, fb->keyframe_interval
+            );
+
+        case CODEC_VP9:
+            return g_strdup_printf(
+                "videoconvert ! vp9enc name=enc deadline=%d cpu-used=%d target-bitrate=%d000 keyframe-max-dist=%d ",
+                DEFAULT_VP9_DEADLINE, DEFAULT_VP9_CPU_USED,
+                fb->bitrate, fb->keyframe_interval
+            );
+
+        default:
+            return g_strdup("");
+    }
+}
+
+/**
+ * UDP sink fragment: plain udpsink for one destination, multiudpsink for
+ * fan-out - packetization and sending are per-destination, the encode
+ * (the expensive part) is paid once.
+ */
+static gchar *build_udpsink_string(FrameBuffer *fb) {
+    if (!fb->extra_dests || fb->extra_dests->len == 0) {
+        return g_strdup_printf("udpsink host=%s port=%d sync=false",
+                               fb->output_host, fb->output_port);
+    }
+
+    GString *clients = g_string_new(NULL);
+    g_string_append_printf(clients, "%s:%d", fb->output_host, fb->output_port);
+    for (guint i = 0; i < fb->extra_dests->len; i++) {
+        g_string_append_printf(clients, ",%s",
+                               (const gchar *)g_ptr_array_index(fb->extra_dests, i));
+    }
+
+    gchar *result = g_strdup_printf("multiudpsink clients=%s sync=false", clients->str);
+    g_string_free(clients, TRUE);
+    return result;
+}
+
+/* "rec.mp4" -> "rec%05d.mp4" so every segment is individually playable */
+static gchar *segment_location_pattern(const char *path) {
+    const char *dot = strrchr(path, '.');
+    if (!dot) {
+        return g_strdup_printf("%s%%05d", path);
+    }
+    return g_strdup_printf("%.*s%%05d%s", (int)(dot - path), path, dot);
+}
+
+/* ========== Build Muxer/Payloader String ========== */
+/* NOTE: All strings start with "! " to properly link after encoder */
+static gchar *build_muxer_string(FrameBuffer *fb) {
+    switch (fb->container) {
+        case CONTAINER_SHM:
+            if (fb->shm_zero_copy) {
+                /* unixfdsink passes memfd handles over the socket instead of
+                 * copying frames into a shm segment: producer and consumers
+                 * share pages. Buffers not already fd-backed are copied into
+                 * memfd once by the sink - still one copy fewer than shmsink
+                 * in, and zero per consumer out. */
+                return g_strdup_printf(
+                    "! unixfdsink socket-path=%s sync=false",
+                    fb->shm_path
+                );
+            }
+            return g_strdup_printf(
+                "! shmsink socket-path=%s shm-size=%" G_GUINT64_FORMAT " wait-for-connection=false sync=false",
+                fb->shm_path, fb->shm_size
+            );
+
+        case CONTAINER_MPEGTS: {
+            gchar *sink_str = build_udpsink_string(fb);
+            gchar *result = g_strdup_printf("! mpegtsmux name=mux ! %s", sink_str);
+            g_free(sink_str);
+            return result;
+        }
+
+        case CONTAINER_RAW_UDP: {
+            gchar *sink_str = build_udpsink_string(fb);
+            gchar *result = g_strdup_printf("! %s", sink_str);
+            g_free(sink_str);
+            return result;
+        }
+
+        case CONTAINER_FILE:
+            if (fb->segment_seconds > 0 && fb->codec != CODEC_RAW) {
+                /* Rotating, individually-playable segments. The leaky queue
+                 * in front means a stalling disk drops recording data
+                 * instead of back-pressuring the paced render path, and
+                 * async-finalize moves segment finalization (the mp4 moov
+                 * write) off the streaming thread. A crash loses at most
+                 * one segment, not the whole recording. */
+                gboolean vpx = (fb->codec == CODEC_VP8 || fb->codec == CODEC_VP9);
+                const char *muxer_factory = vpx ? "matroskamux" : "mp4mux";
+                gchar *pattern = segment_location_pattern(
+                    fb->output_file ? fb->output_file
+                                    : (vpx ? "output.mkv" : "output.mp4"));
+                gchar *result = g_strdup_printf(
+                    "! queue max-size-buffers=0 max-size-time=0 "
+                    "max-size-bytes=10485760 leaky=downstream "
+                    "! splitmuxsink location=%s max-size-time=%" G_GUINT64_FORMAT " "
+                    "muxer-factory=%s async-finalize=true",
+                    pattern,
+                    (guint64)fb->segment_seconds * GST_SECOND,
+                    muxer_factory
+                );
+                g_free(pattern);
+                return result;
+            }
+            /* File muxer based on codec */
+            if (fb->codec == CODEC_RAW) {
+                return g_strdup_printf(
+                    "! avimux ! filesink location=%s",
+                    fb->output_file ? fb->output_file : "output.avi"
+                );
+            } else if (fb->codec == CODEC_VP8 || fb->codec == CODEC_VP9) {
+                return g_strdup_printf(
+                    "! matroskamux ! filesink location=%s",
+                    fb->output_file ? fb->output_file : "output.mkv"
+                );
+            } else {
+                /* H.264, H.265 -> MP4 */
+                return g_strdup_printf(
+                    "! mp4mux name=mux ! filesink location=%s",
+                    fb->output_file ? fb->output_file : "output.mp4"
+                );
+            }
+
+        case CONTAINER_RTP:
+        default:
+            /* RTP payloader depends on codec */
+            switch (fb->codec) {
+                case CODEC_RAW:
+                    {
+                        gchar *sink_str = build_udpsink_string(fb);
+                        gchar *result = g_strdup_printf(
+                            "! rtpvrawpay mtu=%d ! %s",
+                            DEFAULT_RTP_MTU, sink_str);
+                        g_free(sink_str);
+                        return result;
+                    }
+                case CODEC_H264:
+                    {
+                        gchar *sink_str = build_udpsink_string(fb);
+                        gchar *result = g_strdup_printf(
+                            "! rtph264pay config-interval=1 mtu=%d ! %s",
+                            DEFAULT_RTP_MTU, sink_str);
+                        g_free(sink_str);
+                        return result;
+                    }
+                case CODEC_H265:
+                    {
+                        gchar *sink_str = build_udpsink_string(fb);
+                        gchar *result = g_strdup_printf(
+                            "! rtph265pay config-interval=1 mtu=%d ! %s",
+                            DEFAULT_RTP_MTU, sink_str);
+                        g_free(sink_str);
+                        return result;
+                    }
+                case CODEC_VP8:
+                    {
+                        gchar *sink_str = build_udpsink_string(fb);
+                        gchar *result = g_strdup_printf(
+                            "! rtpvp8pay mtu=%d ! %s",
+                            DEFAULT_RTP_MTU, sink_str);
+                        g_free(sink_str);
+                        return result;
+                    }
+                case CODEC_VP9:
+                    {
+                        gchar *sink_str = build_udpsink_string(fb);
+                        gchar *result = g_strdup_printf(
+                            "! rtpvp9pay mtu=%d ! %s",
+                            DEFAULT_RTP_MTU, sink_str);
+                        g_free(sink_str);
+                        return result;
+                    }
+                default: {
+                    gchar *sink_str = build_udpsink_string(fb);
+                    gchar *result = g_strdup_printf("! %s", sink_str);
+                    g_free(sink_str);
+                    return result;
+                }
+            }
+    }
+}
+
+/* ========== Encoded-Frame Repeat Cache ========== */
+
+/* The cache only makes sense where a replayed keyframe is a valid stream:
+ * h264/h265 elementary streams into mpegts, rtp or raw UDP. File outputs
+ * (mp4mux needs monotonic edit lists) and shm keep the classic path. */
+static void validate_repeat_cache(FrameBuffer *fb) {
+    if (!fb->repeat_cache) return;
+
+    gboolean codec_ok = (fb->codec == CODEC_H264 || fb->codec == CODEC_H265);
+    gboolean container_ok = (fb->container == CONTAINER_MPEGTS ||
+                             fb->container == CONTAINER_RTP ||
+                             fb->container == CONTAINER_RAW_UDP);
+
+    if (!codec_ok || !container_ok) {
+        fb_log(fb, "Repeat cache requires h264/h265 to mpegts/rtp/raw output, disabling\n");
+        fb->repeat_cache = FALSE;
+    }
+}
+
+/**
+ * Runs on the encoder streaming thread: forward each encoded frame into
+ * the send stage, keep a ref on the latest keyframe for the repeat path.
+ */
+static GstFlowReturn on_encoded_sample(GstElement *sink, FrameBuffer *fb) {
+    GstSample *sample = gst_app_sink_pull_sample(GST_APP_SINK(sink));
+    if (!sample) return GST_FLOW_ERROR;
+
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstCaps *caps = gst_sample_get_caps(sample);
+
+    /* Keep the mux appsrc caps in sync with the encoder output (set once,
+     * parse output caps are stable after negotiation) */
+    if (caps && (!fb->enc_caps || !gst_caps_is_equal(caps, fb->enc_caps))) {
+        if (fb->enc_caps) gst_caps_unref(fb->enc_caps);
+        fb->enc_caps = gst_caps_ref(caps);
+        g_object_set(fb->mux_appsrc, "caps", caps, NULL);
+    }
+
+    /* Cache keyframes: the render loop takes the pointer with an atomic
+     * exchange, so publish fully-formed refs only */
+    if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+        GstBuffer *old = g_atomic_pointer_exchange(&fb->cached_keyframe,
+                                                   gst_buffer_ref(buffer));
+        if (old) gst_buffer_unref(old);
+    }
+
+    GstFlowReturn ret = gst_app_src_push_buffer(GST_APP_SRC(fb->mux_appsrc),
+                                                gst_buffer_ref(buffer));
+    gst_sample_unref(sample);
+    return ret;
+}
+
+/* Encode stage: raw frames in (same "src" appsrc contract the render loop
+ * always used), parsed encoded frames out through on_encoded_sample() */
+static gboolean create_encode_pipeline(FrameBuffer *fb) {
+    gchar *caps_str = g_strdup_printf(
+        "video/x-raw,format=I420,width=%d,height=%d,framerate=%d/1",
+        fb->width, fb->height, fb->fps
+    );
+    gchar *encoder_str = build_encoder_string(fb);
+
+    gchar *pipeline_str = g_strdup_printf(
+        "appsrc name=src is-live=true format=time do-timestamp=false min-latency=0 "
+        "caps=\"%s\" ! %s! appsink name=encsink emit-signals=true sync=false max-buffers=4",
+        caps_str, encoder_str
+    );
+
+    g_free(caps_str);
+    g_free(encoder_str);
+
+    if (fb->verbose) {
+        fb_log(fb, "Encode pipeline: %s\n", pipeline_str);
+    }
+
+    GError *error = NULL;
+    fb->encode_pipeline = gst_parse_launch(pipeline_str, &error);
+    g_free(pipeline_str);
+
+    if (error) {
+        fb_logerr(fb, "Encode pipeline error: %s\n", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    fb->appsrc = gst_bin_get_by_name(GST_BIN(fb->encode_pipeline), "src");
+    fb->enc_appsink = gst_bin_get_by_name(GST_BIN(fb->encode_pipeline), "encsink");
+    g_signal_connect(fb->enc_appsink, "new-sample", G_CALLBACK(on_encoded_sample), fb);
+
+    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(fb->encode_pipeline));
+    gst_bus_add_signal_watch(bus);
+    g_signal_connect(bus, "message::error", G_CALLBACK(on_bus_error), &fb->encode_bus_ctx);
+    g_signal_connect(bus, "message::warning", G_CALLBACK(on_bus_warning), &fb->encode_bus_ctx);
+    g_signal_connect(bus, "message::eos", G_CALLBACK(on_bus_eos), &fb->encode_bus_ctx);
+    gst_object_unref(bus);
+
+    return TRUE;
+}
+
+/* ========== Create Output Pipeline ========== */
+static gboolean create_output_pipeline(FrameBuffer *fb) {
+    resolve_hw_backend(fb);
+    validate_passthrough(fb);
+    validate_repeat_cache(fb);
+    validate_audio(fb);
+
+    /* Simultaneous recording needs an encoded network output to tee from */
+    if (fb->record_file &&
+        (fb->codec == CODEC_RAW || fb->container == CONTAINER_FILE ||
+         fb->container == CONTAINER_SHM || fb->repeat_cache || fb->passthrough)) {
+        fb_log(fb, "--record needs an encoded network output "
+                "(not raw/file/shm/repeat-cache/passthrough), ignoring\n");
+        g_free(fb->record_file);
+        fb->record_file = NULL;
+    }
+
+    /* Zero-copy IPC needs the unixfd plugin (GStreamer 1.24+) */
+    if (fb->shm_zero_copy && fb->container == CONTAINER_SHM &&
+        !element_exists("unixfdsink")) {
+        fb_log(fb, "unixfdsink not available (GStreamer 1.24+), using shmsink\n");
+        fb->shm_zero_copy = FALSE;
+    }
+
+    gchar *caps_str = g_strdup_printf(
+        "video/x-raw,format=I420,width=%d,height=%d,framerate=%d/1",
+        fb->width, fb->height, fb->fps
+    );
+
+    gchar *encoder_str = build_encoder_string(fb);
+    gchar *muxer_str = build_muxer_string(fb);
+
+    /* For SHM output with encoded video, we need different handling */
+    gboolean shm_with_encoding = (fb->container == CONTAINER_SHM && fb->codec != CODEC_RAW);
 
     /*
      * CRITICAL FIX (intern review):
      * Always use do-timestamp=false because render_loop calculates precise PTS.
      * If do-timestamp=true, appsrc would overwrite our carefully calculated timestamps.
      */
-    const char *appsrc_props = "appsrc name=src is-live=true format=time do-timestamp=false min-latency=0";
+    const char *appsrc_base = "appsrc name=src is-live=true format=time do-timestamp=false min-latency=0";
+
+    /* Preview tap (--preview-port): tee the raw frames right after appsrc
+     * so the downscaled low-fps monitoring branch shares them with the
+     * main chain. Only meaningful where a raw appsrc exists. */
+    if (fb->preview_port > 0 && (fb->passthrough || fb->repeat_cache)) {
+        fb_log(fb, "Preview tap is not supported in passthrough/repeat-cache mode, ignoring\n");
+        fb->preview_port = 0;
+    }
+    gchar *appsrc_props = g_strdup_printf("%s caps=\"%s\"%s",
+        appsrc_base, caps_str,
+        (fb->preview_port > 0) ? " ! tee name=rawt" : "");
 
     gchar *pipeline_str;
-    if (fb->container == CONTAINER_SHM && fb->codec == CODEC_RAW) {
+    if (fb->passthrough) {
+        /* Compressed domain: mux/send only, fed by passthrough_tick()
+         * (muxer_str starts with "!") */
+        pipeline_str = g_strdup_printf(
+            "appsrc name=muxsrc is-live=true format=time do-timestamp=false min-latency=0 "
+            "caps=\"video/x-h264,stream-format=byte-stream,alignment=au\" %s",
+            muxer_str
+        );
+    } else if (fb->repeat_cache) {
+        /* Split mode: the encoder lives in its own pipeline, this one only
+         * muxes/sends what on_encoded_sample() forwards (muxer_str starts
+         * with "!") */
+        if (!create_encode_pipeline(fb)) {
+            g_free(caps_str);
+            g_free(encoder_str);
+            g_free(muxer_str);
+            return FALSE;
+        }
+        pipeline_str = g_strdup_printf(
+            "appsrc name=muxsrc is-live=true format=time do-timestamp=false min-latency=0 %s",
+            muxer_str
+        );
+    } else if (fb->container == CONTAINER_SHM && fb->codec == CODEC_RAW) {
         /* SHM with raw frames (muxer_str starts with "!") */
         pipeline_str = g_strdup_printf(
-            "%s caps=\"%s\" %s",
-            appsrc_props, caps_str, muxer_str
+            "%s %s",
+            appsrc_props, muxer_str
         );
     } else if (shm_with_encoding) {
         /* SHM with encoded video */
         pipeline_str = g_strdup_printf(
-            "%s caps=\"%s\" ! %s%s",
-            appsrc_props, caps_str, encoder_str, muxer_str
+            "%s ! %s%s",
+            appsrc_props, encoder_str, muxer_str
         );
     } else if (fb->codec == CODEC_RAW) {
         /* Raw codec (no encoder) - muxer_str starts with "!" */
         pipeline_str = g_strdup_printf(
-            "%s caps=\"%s\" %s",
-            appsrc_props, caps_str, muxer_str
+            "%s %s",
+            appsrc_props, muxer_str
+        );
+    } else if (fb->record_file) {
+        /* Fan-out recording: tee after the parse so the encode is paid
+         * once and the recording branch muxes independently. The leaky
+         * bounded queue keeps a slow disk off the send path. */
+        const char *rec_mux = (fb->codec == CODEC_VP8 || fb->codec == CODEC_VP9)
+            ? "matroskamux" : "mp4mux";
+        pipeline_str = g_strdup_printf(
+            "%s ! %s! tee name=fanout %s "
+            "fanout. ! queue max-size-buffers=0 max-size-time=0 "
+            "max-size-bytes=10485760 leaky=downstream "
+            "! %s ! filesink location=%s",
+            appsrc_props, encoder_str, muxer_str,
+            rec_mux, fb->record_file
         );
     } else {
         /* Normal output with encoder */
         pipeline_str = g_strdup_printf(
-            "%s caps=\"%s\" ! %s%s",
-            appsrc_props, caps_str, encoder_str, muxer_str
+            "%s ! %s%s",
+            appsrc_props, encoder_str, muxer_str
         );
     }
 
+    g_free(appsrc_props);
     g_free(caps_str);
     g_free(encoder_str);
     g_free(muxer_str);
 
+    /* Preview branch off the raw tee: low-fps, downscaled MJPEG/RTP on its
+     * own port - a 60-channel multiviewer costs percent, not a second
+     * full-rate encode per channel */
+    if (fb->preview_port > 0) {
+        gint pw = 320;
+        gint ph = ((fb->height * pw / fb->width) + 1) & ~1;
+        gchar *with_preview = g_strdup_printf(
+            "%s rawt. ! queue max-size-buffers=2 leaky=downstream "
+            "! videorate drop-only=true ! video/x-raw,framerate=%d/1 "
+            "! videoscale ! video/x-raw,width=%d,height=%d "
+            "! jpegenc quality=60 ! rtpjpegpay ! udpsink host=%s port=%d sync=false",
+            pipeline_str, fb->preview_fps, pw, ph,
+            fb->output_host, fb->preview_port);
+        g_free(pipeline_str);
+        pipeline_str = with_preview;
+    }
+
+    /* Audio branch into the (named) muxer: raw ring -> AAC -> mux */
+    if (fb->audio_enable) {
+        gchar *with_audio = g_strdup_printf(
+            "%s appsrc name=asrc is-live=true format=time do-timestamp=false "
+            "caps=\"audio/x-raw,format=S16LE,layout=interleaved,rate=%d,channels=%d\" "
+            "! audioconvert ! %s bitrate=128000 ! aacparse ! mux.",
+            pipeline_str, AUDIO_RATE, AUDIO_CHANNELS, fb->aac_factory);
+        g_free(pipeline_str);
+        pipeline_str = with_audio;
+    }
+
+    if (fb->verbose) {
+        fb_log(fb, "Output pipeline: %s\n", pipeline_str);
+    }
+
+    GError *error = NULL;
+    fb->output_pipeline = gst_parse_launch(pipeline_str, &error);
+    g_free(pipeline_str);
+
+    if (error) {
+        fb_logerr(fb, "Output pipeline error: %s\n", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    if (fb->repeat_cache || fb->passthrough) {
+        fb->mux_appsrc = gst_bin_get_by_name(GST_BIN(fb->output_pipeline), "muxsrc");
+    } else {
+        fb->appsrc = gst_bin_get_by_name(GST_BIN(fb->output_pipeline), "src");
+    }
+
+    if (fb->audio_enable) {
+        fb->audio_appsrc = gst_bin_get_by_name(GST_BIN(fb->output_pipeline), "asrc");
+    }
+
+    /* Add bus watchers for output pipeline */
+    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(fb->output_pipeline));
+    gst_bus_add_signal_watch(bus);
+    g_signal_connect(bus, "message::error", G_CALLBACK(on_bus_error), &fb->output_bus_ctx);
+    g_signal_connect(bus, "message::warning", G_CALLBACK(on_bus_warning), &fb->output_bus_ctx);
+    g_signal_connect(bus, "message::eos", G_CALLBACK(on_bus_eos), &fb->output_bus_ctx);
+    gst_object_unref(bus);
+
+    /* Print output info */
+    if (fb->container == CONTAINER_SHM) {
+        fb_log(fb, "Output: %s/%s @ %s, %dx%d @ %dfps\n",
+                codec_to_string(fb->codec), container_to_string(fb->container),
+                fb->shm_path, fb->width, fb->height, fb->fps);
+    } else if (fb->container == CONTAINER_FILE) {
+        fb_log(fb, "Output: %s/%s @ %s, %dx%d @ %dfps",
+                codec_to_string(fb->codec), container_to_string(fb->container),
+                fb->output_file ? fb->output_file : "output.*",
+                fb->width, fb->height, fb->fps);
+        if (fb->codec != CODEC_RAW) {
+            g_print(", %dkbps", fb->bitrate);
+        }
+        g_print("\n");
+    } else {
+        fb_log(fb, "Output: %s/%s @ %s:%d, %dx%d @ %dfps",
+                codec_to_string(fb->codec), container_to_string(fb->container),
+                fb->output_host, fb->output_port,
+                fb->width, fb->height, fb->fps);
+        if (fb->codec != CODEC_RAW) {
+            g_print(", %dkbps", fb->bitrate);
+        }
+        if (fb->repeat_cache) {
+            g_print(", repeat cache");
+        }
+        if (fb->passthrough) {
+            g_print(", passthrough");
+        }
+        g_print("\n");
+    }
+
+    return TRUE;
+}
+
+/* ========== New Sample Callback ========== */
+
+/**
+ * Sampled Y-plane checksum for --change-detect: every 64th 64-bit word of
+ * the luma plane (~1.5% of the bytes, ~32KB touched at 1080p). Not a
+ * cryptographic hash - just enough to classify "the picture didn't
+ * change". Seeded with the FNV-64 offset so an all-black frame doesn't
+ * collide with the "no hash" sentinel 0.
+ */
+static guint64 frame_content_hash(GstBuffer *buffer, gsize y_size) {
+    GstMapInfo map;
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) return 0;
+
+    gsize limit = ((map.size < y_size) ? map.size : y_size) / sizeof(guint64);
+    const guint64 *words = (const guint64 *)(void *)map.data;
+    guint64 hash = 14695981039346656037ULL;
+    for (gsize i = 0; i < limit; i += 64) {
+        hash = hash * 31 + words[i];
+    }
+
+    gst_buffer_unmap(buffer, &map);
+    return hash;
+}
+
+/* Producer-thread-only EWMAs (1/16 gain, RFC3550 flavour); the deviation
+ * is published atomically for the adaptation timer */
+static void record_arrival_jitter(FrameBuffer *fb, guint64 arrival_ns) {
+    if (fb->last_arrival_ns != 0) {
+        guint64 delta = arrival_ns - fb->last_arrival_ns;
+        if (fb->mean_interval_ns == 0) {
+            fb->mean_interval_ns = delta;
+        } else {
+            fb->mean_interval_ns = (fb->mean_interval_ns * 15 + delta) / 16;
+        }
+        guint64 dev = (delta > fb->mean_interval_ns)
+            ? delta - fb->mean_interval_ns
+            : fb->mean_interval_ns - delta;
+        guint64 jitter = (STAT_READ(fb->arrival_jitter_ns) * 15 + dev) / 16;
+        STAT_SET(fb->arrival_jitter_ns, jitter);
+    }
+    fb->last_arrival_ns = arrival_ns;
+}
+
+static GstFlowReturn handle_input_sample(GstElement *sink, FrameBuffer *fb,
+                                         gboolean from_backup) {
+    GstSample *sample = gst_app_sink_pull_sample(GST_APP_SINK(sink));
+    if (!sample) return GST_FLOW_ERROR;
+
+    /* Health timestamp for the failover scorer, whichever input this is */
+    guint64 arrival_ns = (guint64)g_get_monotonic_time() * 1000;
+    if (from_backup) {
+        STAT_SET(fb->backup_last_ns, arrival_ns);
+    } else {
+        STAT_SET(fb->primary_last_ns, arrival_ns);
+    }
+
+    /* Only the active input publishes into the frame slot; the standby
+     * decodes (so it is hot) but its frames stop here */
+    gint active = g_atomic_int_get(&fb->active_input);
+    if (from_backup != (active == INPUT_BACKUP)) {
+        gst_sample_unref(sample);
+        return GST_FLOW_OK;
+    }
+
+    /* The triple buffer is strictly single-producer. If a failover flip
+     * lands between the gate above and the slot work below, both inputs
+     * could be "active" for one sample - the CAS keeps the second one out
+     * (it drops a single frame, the paced output never notices). */
+    if (!g_atomic_int_compare_and_exchange(&fb->producer_busy, 0, 1)) {
+        gst_sample_unref(sample);
+        return GST_FLOW_OK;
+    }
+
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstCaps *caps = gst_sample_get_caps(sample);
+
+    /* Fill our private slot - no other thread can touch it between swaps */
+    FrameSlot *slot = fb->input_slot;
+    if (slot->buffer) {
+        gst_buffer_unref(slot->buffer);  /* Stale frame from two swaps ago */
+    }
+    slot->buffer = gst_buffer_ref(buffer);
+    slot->input_time = (GstClockTime)g_get_monotonic_time() * 1000;  /* us -> ns */
+    slot->content_hash = fb->change_detect
+        ? frame_content_hash(buffer, (gsize)fb->width * fb->height)
+        : 0;
+    if (fb->jitter_adaptive && !from_backup) {
+        record_arrival_jitter(fb, slot->input_time);
+    }
+    STAT_INC(fb->stats_in.frames_in);
+    fb->stats_in.in_seq++;
+    slot->seq = fb->stats_in.in_seq;
+
+    /* caps-change logging is producer-thread-only state, no sync needed */
+    if (caps && (!fb->current_caps || !gst_caps_is_equal(caps, fb->current_caps))) {
+        if (fb->current_caps) {
+            gst_caps_unref(fb->current_caps);
+            /* Log caps change for debugging (input scaled to output size by videoscale) */
+            gchar *caps_str = gst_caps_to_string(caps);
+            fb_log(fb, "Input caps changed: %s\n", caps_str);
+            g_free(caps_str);
+        }
+        fb->current_caps = gst_caps_ref(caps);
+    }
+
+    /* Publish: one atomic exchange, then raise the flag. The slot we get
+     * back (previous pending) becomes our next scratch slot. */
+    fb->input_slot = g_atomic_pointer_exchange(&fb->pending_slot, slot);
+    g_atomic_int_set(&fb->frame_available, 1);
+
+    g_atomic_int_set(&fb->producer_busy, 0);
+
+    gst_sample_unref(sample);
+
+    return GST_FLOW_OK;
+}
+
+static GstFlowReturn on_new_sample(GstElement *sink, FrameBuffer *fb) {
+    return handle_input_sample(sink, fb, FALSE);
+}
+
+static GstFlowReturn on_backup_sample(GstElement *sink, FrameBuffer *fb) {
+    return handle_input_sample(sink, fb, TRUE);
+}
+
+/* ========== Adaptive Jitter Buffer ========== */
+
+/**
+ * Every 2s: size the queue threshold at 4x the measured arrival-jitter
+ * EWMA plus a 10ms guard, clamped to [min,max], moving halfway per step
+ * so the buffer neither oscillates nor jumps. Applied live on the named
+ * jbuf queue - no pipeline rebuild.
+ */
+static gboolean jitter_adapt_check(gpointer data) {
+    FrameBuffer *fb = (FrameBuffer *)data;
+
+    if (!fb->input_pipeline) return G_SOURCE_CONTINUE;
+
+    guint64 jitter_ns = STAT_READ(fb->arrival_jitter_ns);
+    if (jitter_ns == 0) return G_SOURCE_CONTINUE;
+
+    guint64 target_ms = (4 * jitter_ns) / GST_MSECOND + 10;
+    if (target_ms < fb->jitter_min_ms) target_ms = fb->jitter_min_ms;
+    if (target_ms > fb->jitter_max_ms) target_ms = fb->jitter_max_ms;
+
+    guint64 next_ms = (fb->jitter_current_ms + target_ms) / 2;
+    guint64 diff = (next_ms > fb->jitter_current_ms)
+        ? next_ms - fb->jitter_current_ms
+        : fb->jitter_current_ms - next_ms;
+    if (diff < 5) return G_SOURCE_CONTINUE;
+
+    fb->jitter_current_ms = next_ms;
+
+    GstElement *jbuf = gst_bin_get_by_name(GST_BIN(fb->input_pipeline), "jbuf");
+    if (jbuf) {
+        g_object_set(jbuf, "min-threshold-time",
+                     (guint64)(next_ms * GST_MSECOND), NULL);
+        gst_object_unref(jbuf);
+        if (fb->verbose) {
+            fb_log(fb, "Jitter buffer adapted to %" G_GUINT64_FORMAT
+                    "ms (arrival jitter %.1fms)\n",
+                    next_ms, (gdouble)jitter_ns / 1e6);
+        }
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+/* ========== Input-Stall Watchdog ========== */
+
+/**
+ * Runs every second. Progress on frames_in resets everything; a stall
+ * longer than stall_timeout_ms (doubled per fruitless restart, capped at
+ * 64x) forces the restart path that bus errors normally trigger. Covers
+ * the most common production failure: a source that keeps the socket
+ * open but stops sending, which produces no bus error at all.
+ */
+static gboolean watchdog_check(gpointer data) {
+    FrameBuffer *fb = (FrameBuffer *)data;
+
+    guint64 frames = STAT_READ(fb->stats_in.frames_in);
+    if (frames != fb->watchdog_last_frames) {
+        fb->watchdog_last_frames = frames;
+        fb->watchdog_stalled_ms = 0;
+        fb->watchdog_backoff = 0;
+        return G_SOURCE_CONTINUE;
+    }
+
+    fb->watchdog_stalled_ms += WATCHDOG_CHECK_MS;
+
+    guint64 threshold_ms = fb->stall_timeout_ms << fb->watchdog_backoff;
+    if (fb->watchdog_stalled_ms >= threshold_ms && !fb->input_restart_pending) {
+        fb_log(fb, "Watchdog: no input frames for %" G_GUINT64_FORMAT
+                "ms, forcing input restart (backoff %u)\n",
+                fb->watchdog_stalled_ms, fb->watchdog_backoff);
+        if (fb->watchdog_backoff < 6) {
+            fb->watchdog_backoff++;
+        }
+        fb->watchdog_stalled_ms = 0;
+        fb->input_restart_pending = TRUE;
+        fb->restart_timeout_id = g_idle_add(restart_input_pipeline, fb);
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+/* ========== Failover Scorer ========== */
+
+/**
+ * 50 ms health check: an input is fresh if a frame arrived within ~3 frame
+ * intervals. Primary loss with a fresh backup promotes the backup; primary
+ * recovery demotes it again. Runs on the main loop, flips one atomic.
+ */
+static gboolean failover_check(gpointer data) {
+    FrameBuffer *fb = (FrameBuffer *)data;
+
+    guint64 now_ns = (guint64)g_get_monotonic_time() * 1000;
+    guint64 stale_ns = 3 * gst_util_uint64_scale_int(1, GST_SECOND, fb->fps);
+    if (stale_ns < 100 * GST_MSECOND) stale_ns = 100 * GST_MSECOND;
+
+    guint64 primary_last = STAT_READ(fb->primary_last_ns);
+    guint64 backup_last = STAT_READ(fb->backup_last_ns);
+    gboolean primary_fresh = primary_last > 0 && (now_ns - primary_last) < stale_ns;
+    gboolean backup_fresh = backup_last > 0 && (now_ns - backup_last) < stale_ns;
+
+    gint active = g_atomic_int_get(&fb->active_input);
+
+    if (active == INPUT_PRIMARY && !primary_fresh && backup_fresh) {
+        g_atomic_int_set(&fb->active_input, INPUT_BACKUP);
+        fb->failover_count++;
+        fb_log(fb, "Failover: primary stale, backup (port %d) promoted\n",
+                fb->backup_port);
+    } else if (active == INPUT_BACKUP && primary_fresh) {
+        g_atomic_int_set(&fb->active_input, INPUT_PRIMARY);
+        fb_log(fb, "Failover: primary recovered, switching back\n");
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+/* Backup input: a plain udpsrc on --backup-port feeding the same frame
+ * slot through handle_input_sample(). Kept PLAYING (hot decode) so a
+ * promotion costs no pipeline rebuild. */
+static gboolean create_backup_pipeline(FrameBuffer *fb) {
+    GError *error = NULL;
+
+    /* Same jitter buffer as the primary: both inputs must sit at the same
+     * depth in the stream or every switch would jump the content by the
+     * buffer length. The backup flows continuously, so its queue is
+     * already filled when a promotion happens. */
+    guint64 jitter_ns = fb->jitter_buffer_ms * 1000000ULL;
+    guint64 max_time_ns = fb->max_queue_time_ms * 1000000ULL;
+    const char *convert_chain = fb->accel_chain
+        ? fb->accel_chain
+        : "videoconvert name=conv ! videoscale add-borders=true";
+
+    gchar *pipeline_str = g_strdup_printf(
+        "udpsrc port=%d buffer-size=%" G_GUINT64_FORMAT " "
+        "caps=\"video/mpegts,systemstream=true\" "
+        "! queue min-threshold-time=%" G_GUINT64_FORMAT " "
+        "max-size-buffers=0 max-size-bytes=0 max-size-time=%" G_GUINT64_FORMAT " "
+        "! tsparse "
+        "! decodebin3 "
+        "! %s "
+        "! video/x-raw,format=I420,width=%d,height=%d "
+        "! appsink name=backupsink emit-signals=true sync=false max-buffers=%d drop=true",
+        fb->backup_port,
+        fb->udp_buffer_size,
+        jitter_ns,
+        max_time_ns,
+        convert_chain,
+        fb->width,
+        fb->height,
+        fb->appsink_max_buffers
+    );
+
     if (fb->verbose) {
-        g_print("[FrameBuffer] Output pipeline: %s\n", pipeline_str);
+        fb_log(fb, "Backup pipeline: %s\n", pipeline_str);
     }
 
-    GError *error = NULL;
-    fb->output_pipeline = gst_parse_launch(pipeline_str, &error);
+    fb->backup_pipeline = gst_parse_launch(pipeline_str, &error);
     g_free(pipeline_str);
 
     if (error) {
-        g_printerr("[FrameBuffer] Output pipeline error: %s\n", error->message);
+        fb_logerr(fb, "Failed to create backup pipeline: %s\n", error->message);
         g_error_free(error);
         return FALSE;
     }
 
-    fb->appsrc = gst_bin_get_by_name(GST_BIN(fb->output_pipeline), "src");
+    fb->backup_appsink = gst_bin_get_by_name(GST_BIN(fb->backup_pipeline), "backupsink");
+    g_signal_connect(fb->backup_appsink, "new-sample", G_CALLBACK(on_backup_sample), fb);
 
-    /* Add bus watchers for output pipeline */
-    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(fb->output_pipeline));
+    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(fb->backup_pipeline));
     gst_bus_add_signal_watch(bus);
-    g_signal_connect(bus, "message::error", G_CALLBACK(on_bus_error), (gpointer)"OUTPUT");
-    g_signal_connect(bus, "message::warning", G_CALLBACK(on_bus_warning), (gpointer)"OUTPUT");
-    g_signal_connect(bus, "message::eos", G_CALLBACK(on_bus_eos), (gpointer)"OUTPUT");
+    g_signal_connect(bus, "message::error", G_CALLBACK(on_bus_error), &fb->backup_bus_ctx);
+    g_signal_connect(bus, "message::warning", G_CALLBACK(on_bus_warning), &fb->backup_bus_ctx);
+    g_signal_connect(bus, "message::eos", G_CALLBACK(on_bus_eos), &fb->backup_bus_ctx);
     gst_object_unref(bus);
 
-    /* Print output info */
-    if (fb->container == CONTAINER_SHM) {
-        g_print("[FrameBuffer] Output: %s/%s @ %s, %dx%d @ %dfps\n",
-                codec_to_string(fb->codec), container_to_string(fb->container),
-                fb->shm_path, fb->width, fb->height, fb->fps);
-    } else if (fb->container == CONTAINER_FILE) {
-        g_print("[FrameBuffer] Output: %s/%s @ %s, %dx%d @ %dfps",
-                codec_to_string(fb->codec), container_to_string(fb->container),
-                fb->output_file ? fb->output_file : "output.*",
-                fb->width, fb->height, fb->fps);
-        if (fb->codec != CODEC_RAW) {
-            g_print(", %dkbps", fb->bitrate);
-        }
-        g_print("\n");
-    } else {
-        g_print("[FrameBuffer] Output: %s/%s @ %s:%d, %dx%d @ %dfps",
-                codec_to_string(fb->codec), container_to_string(fb->container),
-                fb->output_host, fb->output_port,
-                fb->width, fb->height, fb->fps);
-        if (fb->codec != CODEC_RAW) {
-            g_print(", %dkbps", fb->bitrate);
-        }
-        g_print("\n");
+    fb_log(fb, "Backup input: UDP port %d (hot standby)\n", fb->backup_port);
+    return TRUE;
+}
+
+/* ========== Frame Buffer Pool ========== */
+
+/**
+ * Pre-sized pool for locally-created I420 frames (fallback frame today,
+ * anything else that needs a writable raw frame tomorrow). Decoder output
+ * is already pool-managed by the decoder; this covers our own allocations
+ * so day-long runs don't fragment the glib/GStreamer heap.
+ */
+static gboolean create_frame_pool(FrameBuffer *fb) {
+    gsize frame_size = (gsize)fb->width * fb->height * 3 / 2;
+
+    fb->pool = gst_buffer_pool_new();
+    GstStructure *config = gst_buffer_pool_get_config(fb->pool);
+
+    gchar *caps_str = g_strdup_printf(
+        "video/x-raw,format=I420,width=%d,height=%d,framerate=%d/1",
+        fb->width, fb->height, fb->fps
+    );
+    GstCaps *caps = gst_caps_from_string(caps_str);
+    g_free(caps_str);
+
+    gst_buffer_pool_config_set_params(config, caps, frame_size, 2, 8);
+    gst_caps_unref(caps);
+
+    if (!gst_buffer_pool_set_config(fb->pool, config) ||
+        !gst_buffer_pool_set_active(fb->pool, TRUE)) {
+        fb_logerr(fb, "Failed to configure frame pool, falling back to heap allocation\n");
+        gst_object_unref(fb->pool);
+        fb->pool = NULL;
+        return FALSE;
     }
 
     return TRUE;
 }
 
-/* ========== New Sample Callback ========== */
-static GstFlowReturn on_new_sample(GstElement *sink, FrameBuffer *fb) {
-    GstSample *sample = gst_app_sink_pull_sample(GST_APP_SINK(sink));
-    if (!sample) return GST_FLOW_ERROR;
+/* Acquire a writable frame-sized buffer, from the pool when it exists */
+static GstBuffer *acquire_frame_buffer(FrameBuffer *fb) {
+    if (fb->pool) {
+        GstBuffer *buffer = NULL;
+        if (gst_buffer_pool_acquire_buffer(fb->pool, &buffer, NULL) == GST_FLOW_OK) {
+            return buffer;
+        }
+    }
+    STAT_FETCH_ADD(fb->frame_path_allocs, 1);
+    return gst_buffer_new_allocate(NULL, (gsize)fb->width * fb->height * 3 / 2, NULL);
+}
 
-    GstBuffer *buffer = gst_sample_get_buffer(sample);
-    GstCaps *caps = gst_sample_get_caps(sample);
+/* ========== Fallback Slate From File ========== */
+
+/**
+ * Decode a branded "signal lost" slate (PNG/JPEG) once at startup into an
+ * I420 frame at output size. Runs a short-lived decode pipeline, pulls the
+ * preroll, copies the pixels into a pool buffer and tears everything down.
+ * Returns NULL (caller keeps the grey fallback) on any failure.
+ */
+static GstBuffer *load_fallback_image(FrameBuffer *fb) {
+    GError *error = NULL;
+
+    gchar *pipeline_str = g_strdup_printf(
+        "filesrc location=\"%s\" ! decodebin ! videoconvert ! videoscale add-borders=true "
+        "! video/x-raw,format=I420,width=%d,height=%d "
+        "! appsink name=slatesink",
+        fb->fallback_image, fb->width, fb->height
+    );
 
-    g_mutex_lock(&fb->frame_mutex);
+    GstElement *pipe = gst_parse_launch(pipeline_str, &error);
+    g_free(pipeline_str);
 
-    if (fb->current_frame) {
-        gst_buffer_unref(fb->current_frame);
+    if (error) {
+        fb_logerr(fb, "Failed to build slate pipeline for %s: %s\n",
+                  fb->fallback_image, error->message);
+        g_error_free(error);
+        return NULL;
     }
-    fb->current_frame = gst_buffer_ref(buffer);
 
-    if (caps && (!fb->current_caps || !gst_caps_is_equal(caps, fb->current_caps))) {
-        if (fb->current_caps) {
-            gst_caps_unref(fb->current_caps);
-            /* Log caps change for debugging (input scaled to output size by videoscale) */
-            gchar *caps_str = gst_caps_to_string(caps);
-            g_print("[FrameBuffer] Input caps changed: %s\n", caps_str);
-            g_free(caps_str);
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipe), "slatesink");
+    gst_element_set_state(pipe, GST_STATE_PAUSED);
+
+    GstSample *sample = gst_app_sink_try_pull_preroll(GST_APP_SINK(sink), 5 * GST_SECOND);
+
+    GstBuffer *slate = NULL;
+    if (sample) {
+        GstBuffer *decoded = gst_sample_get_buffer(sample);
+        GstMapInfo src_map, dst_map;
+        if (gst_buffer_map(decoded, &src_map, GST_MAP_READ)) {
+            slate = acquire_frame_buffer(fb);
+            if (gst_buffer_map(slate, &dst_map, GST_MAP_WRITE)) {
+                gsize n = (src_map.size < dst_map.size) ? src_map.size : dst_map.size;
+                memcpy(dst_map.data, src_map.data, n);
+                gst_buffer_unmap(slate, &dst_map);
+            } else {
+                gst_buffer_unref(slate);
+                slate = NULL;
+            }
+            gst_buffer_unmap(decoded, &src_map);
         }
-        fb->current_caps = gst_caps_ref(caps);
+        gst_sample_unref(sample);
+    } else {
+        fb_logerr(fb, "Could not decode fallback image %s\n", fb->fallback_image);
     }
 
-    fb->frames_in++;
-    fb->in_seq++;
-    fb->last_input_time = g_get_monotonic_time() * 1000;  /* Record input time (ns) */
+    gst_element_set_state(pipe, GST_STATE_NULL);
+    gst_object_unref(sink);
+    gst_object_unref(pipe);
 
-    g_mutex_unlock(&fb->frame_mutex);
+    return slate;
+}
 
-    gst_sample_unref(sample);
+/**
+ * Pre-encode the fallback slate through a short-lived encoder pipeline and
+ * seed the repeat cache with the resulting keyframe. Signal loss then
+ * splices an already-encoded slate into the output from the very first
+ * cached tick - no encoder session needed to render "no signal".
+ * Only meaningful in --repeat-cache mode (the cache is the splice point).
+ */
+static void preencode_fallback_slate(FrameBuffer *fb) {
+    if (!fb->repeat_cache || !fb->fallback_frame) return;
 
-    return GST_FLOW_OK;
+    GError *error = NULL;
+    gchar *caps_str = g_strdup_printf(
+        "video/x-raw,format=I420,width=%d,height=%d,framerate=%d/1",
+        fb->width, fb->height, fb->fps
+    );
+    gchar *encoder_str = build_encoder_string(fb);
+
+    gchar *pipeline_str = g_strdup_printf(
+        "appsrc name=slatesrc format=time caps=\"%s\" "
+        "! %s! appsink name=slateout sync=false",
+        caps_str, encoder_str
+    );
+    g_free(caps_str);
+    g_free(encoder_str);
+
+    GstElement *pipe = gst_parse_launch(pipeline_str, &error);
+    g_free(pipeline_str);
+
+    if (error) {
+        fb_logerr(fb, "Failed to build slate encoder: %s\n", error->message);
+        g_error_free(error);
+        return;
+    }
+
+    GstElement *src = gst_bin_get_by_name(GST_BIN(pipe), "slatesrc");
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipe), "slateout");
+
+    gst_element_set_state(pipe, GST_STATE_PLAYING);
+
+    GstBuffer *frame = gst_buffer_make_writable(gst_buffer_ref(fb->fallback_frame));
+    GST_BUFFER_PTS(frame) = 0;
+    GST_BUFFER_DTS(frame) = 0;
+    GST_BUFFER_DURATION(frame) = gst_util_uint64_scale_int(1, GST_SECOND, fb->fps);
+    gst_app_src_push_buffer(GST_APP_SRC(src), frame);
+    gst_app_src_end_of_stream(GST_APP_SRC(src));
+
+    GstSample *sample = gst_app_sink_try_pull_sample(GST_APP_SINK(sink), 5 * GST_SECOND);
+    if (sample) {
+        GstBuffer *encoded = gst_sample_get_buffer(sample);
+        GstCaps *caps = gst_sample_get_caps(sample);
+
+        /* Seed the mux caps too, so a channel that never sees input still
+         * negotiates its send pipeline */
+        if (caps && fb->mux_appsrc) {
+            if (fb->enc_caps) gst_caps_unref(fb->enc_caps);
+            fb->enc_caps = gst_caps_ref(caps);
+            g_object_set(fb->mux_appsrc, "caps", caps, NULL);
+        }
+
+        /* Keep our own ref too: live keyframes will overwrite the cache,
+         * and the render loop swaps the slate back in on signal loss */
+        if (fb->slate_keyframe) gst_buffer_unref(fb->slate_keyframe);
+        fb->slate_keyframe = gst_buffer_ref(encoded);
+
+        GstBuffer *old = g_atomic_pointer_exchange(&fb->cached_keyframe,
+                                                   gst_buffer_ref(encoded));
+        if (old) gst_buffer_unref(old);
+        gst_sample_unref(sample);
+        fb_log(fb, "Pre-encoded fallback slate cached\n");
+    } else {
+        fb_logerr(fb, "Slate pre-encode produced no output\n");
+    }
+
+    gst_element_set_state(pipe, GST_STATE_NULL);
+    gst_object_unref(src);
+    gst_object_unref(sink);
+    gst_object_unref(pipe);
 }
 
 /* ========== Create Fallback Frame ========== */
 static GstBuffer *create_fallback_frame(FrameBuffer *fb) {
     gsize y_size = fb->width * fb->height;
     gsize uv_size = y_size / 4;
-    gsize total_size = y_size + 2 * uv_size;
 
-    GstBuffer *buffer = gst_buffer_new_allocate(NULL, total_size, NULL);
+    GstBuffer *buffer = acquire_frame_buffer(fb);
 
     GstMapInfo map;
     gst_buffer_map(buffer, &map, GST_MAP_WRITE);
@@ -666,20 +2597,381 @@ static GstBuffer *create_fallback_frame(FrameBuffer *fb) {
     return buffer;
 }
 
+/* ========== Audio Channel ========== */
+
+/**
+ * Audio only fits outputs that can mux it; anything else logs and drops
+ * the flag. Probes an AAC encoder (avenc_aac from gst-libav, voaacenc as
+ * fallback). Same idempotence pattern as the passthrough validation.
+ */
+static void validate_audio(FrameBuffer *fb) {
+    if (!fb->audio_enable || fb->audio_queue) return;
+
+    if (fb->bench || fb->passthrough) {
+        fb_log(fb, "Audio channel not supported in bench/passthrough mode, disabling\n");
+        fb->audio_enable = FALSE;
+        return;
+    }
+    if (fb->container != CONTAINER_MPEGTS &&
+        !(fb->container == CONTAINER_FILE && fb->segment_seconds == 0 &&
+          fb->codec != CODEC_RAW && fb->codec != CODEC_VP8 && fb->codec != CODEC_VP9)) {
+        fb_log(fb, "Audio channel requires mpegts or mp4 file output, disabling\n");
+        fb->audio_enable = FALSE;
+        return;
+    }
+
+    if (element_exists("avenc_aac")) {
+        fb->aac_factory = "avenc_aac";
+    } else if (element_exists("voaacenc")) {
+        fb->aac_factory = "voaacenc";
+    } else {
+        fb_log(fb, "No AAC encoder found (gst-libav / voaacenc), disabling audio\n");
+        fb->audio_enable = FALSE;
+        return;
+    }
+
+    fb->audio_queue = g_async_queue_new();
+    fb->silence_frame = gst_buffer_new_allocate(NULL, AUDIO_CHUNK_BYTES, NULL);
+    GstMapInfo map;
+    gst_buffer_map(fb->silence_frame, &map, GST_MAP_WRITE);
+    memset(map.data, 0, map.size);
+    gst_buffer_unmap(fb->silence_frame, &map);
+}
+
+/* Audio streaming thread: ring the decoded audio, drop on pathology */
+static GstFlowReturn on_audio_sample(GstElement *sink, FrameBuffer *fb) {
+    GstSample *sample = gst_app_sink_pull_sample(GST_APP_SINK(sink));
+    if (!sample) return GST_FLOW_ERROR;
+
+    if (g_async_queue_length(fb->audio_queue) < 256) {
+        g_async_queue_push(fb->audio_queue,
+                           gst_buffer_ref(gst_sample_get_buffer(sample)));
+    }
+    gst_sample_unref(sample);
+    return GST_FLOW_OK;
+}
+
+/**
+ * Called once per video tick from the render loop: forward ringed audio
+ * retimed onto our own audio timeline, bounded slightly ahead of the
+ * video clock, and silence-fill when the source carries no (or not
+ * enough) audio so the mux never starves.
+ */
+static void audio_tick(FrameBuffer *fb, GstClockTime video_pts, GstClockTime duration) {
+    GstClockTime target = video_pts + duration;
+    GstBuffer *b;
+
+    /* Audio must never hit enqueue_push()'s drop path: a dropped chunk
+     * would advance past a hole the silence-filler can no longer cover
+     * (it only fills while audio_pts lags the video target) and starve
+     * the muxer. Gate every enqueue on queue slack instead - audio_pts
+     * then only advances for chunks actually accepted, and whatever was
+     * held back stays ringed (or is silence-filled) on a later tick.
+     * Dropping a paced video tick preserves cadence; dropping audio
+     * doesn't. */
+    while (fb->audio_pts < target + 500 * GST_MSECOND &&
+           push_queue_has_slack(fb) &&
+           (b = g_async_queue_try_pop(fb->audio_queue)) != NULL) {
+        gsize size = gst_buffer_get_size(b);
+        GstClockTime dur = gst_util_uint64_scale(size / (AUDIO_CHANNELS * 2),
+                                                 GST_SECOND, AUDIO_RATE);
+        b = gst_buffer_make_writable(b);
+        GST_BUFFER_PTS(b) = fb->audio_pts;
+        GST_BUFFER_DTS(b) = fb->audio_pts;
+        GST_BUFFER_DURATION(b) = dur;
+        fb->audio_pts += dur;
+        enqueue_push(fb, fb->audio_appsrc, b);
+    }
+
+    /* Gap about to open between audio and video timelines: fill it
+     * (same slack gate - an unfilled gap just waits for the next tick) */
+    while (fb->audio_pts + AUDIO_CHUNK_NS <= target &&
+           push_queue_has_slack(fb)) {
+        GstBuffer *silence = gst_buffer_make_writable(gst_buffer_ref(fb->silence_frame));
+        GST_BUFFER_PTS(silence) = fb->audio_pts;
+        GST_BUFFER_DTS(silence) = fb->audio_pts;
+        GST_BUFFER_DURATION(silence) = AUDIO_CHUNK_NS;
+        fb->audio_pts += AUDIO_CHUNK_NS;
+        enqueue_push(fb, fb->audio_appsrc, silence);
+    }
+}
+
+/* ========== Pipelined Push Stage ========== */
+
+#define PUSH_QUEUE_MAX 4
+
+typedef struct {
+    GstBuffer *buffer;          /* NULL = shutdown sentinel */
+    GstElement *target;         /* appsrc to push into */
+} PushItem;
+
+/* Feeder thread: absorbs appsrc/encoder back-pressure off the paced path */
+static gpointer push_loop(gpointer data) {
+    FrameBuffer *fb = (FrameBuffer *)data;
+
+    while (TRUE) {
+        PushItem *item = g_async_queue_pop(fb->push_queue);
+        if (!item->buffer) {
+            g_free(item);
+            break;
+        }
+        GstFlowReturn ret = gst_app_src_push_buffer(GST_APP_SRC(item->target),
+                                                    item->buffer);
+        if (ret == GST_FLOW_FLUSHING || ret == GST_FLOW_EOS) {
+            g_atomic_int_set(&fb->push_flushing, 1);
+        }
+        g_free(item);
+    }
+    return NULL;
+}
+
+/**
+ * Pacer-side enqueue: constant-time, never blocks. On a full queue the
+ * frame is dropped (counted) - the output cadence is the product, a
+ * dropped tick during an encoder hiccup beats a cascading clock miss.
+ */
+static GstFlowReturn enqueue_push(FrameBuffer *fb, GstElement *target, GstBuffer *buffer) {
+    if (g_atomic_int_get(&fb->push_flushing)) {
+        gst_buffer_unref(buffer);
+        return GST_FLOW_FLUSHING;
+    }
+    if (g_async_queue_length(fb->push_queue) >= PUSH_QUEUE_MAX) {
+        gst_buffer_unref(buffer);
+        STAT_INC(fb->stats_out.pushes_dropped);
+        return GST_FLOW_OK;
+    }
+
+    PushItem *item = g_new0(PushItem, 1);
+    item->buffer = buffer;
+    item->target = target;
+    g_async_queue_push(fb->push_queue, item);
+    return GST_FLOW_OK;
+}
+
+/* The pacer thread is the queue's only producer, so a positive answer
+ * here guarantees the next enqueue_push() is accepted - the feeder can
+ * only shrink the queue concurrently. Lets callers that must not lose
+ * buffers (audio) hold back instead of having them silently dropped. */
+static gboolean push_queue_has_slack(FrameBuffer *fb) {
+    return g_async_queue_length(fb->push_queue) < PUSH_QUEUE_MAX;
+}
+
+static void stop_push_thread(FrameBuffer *fb) {
+    if (!fb->push_thread) return;
+
+    PushItem *sentinel = g_new0(PushItem, 1);
+    g_async_queue_push(fb->push_queue, sentinel);
+    g_thread_join(fb->push_thread);
+    fb->push_thread = NULL;
+
+    PushItem *item;
+    while ((item = g_async_queue_try_pop(fb->push_queue)) != NULL) {
+        if (item->buffer) gst_buffer_unref(item->buffer);
+        g_free(item);
+    }
+}
+
+/* ========== Compressed-Domain Passthrough ========== */
+
+/**
+ * One output tick in the compressed domain. Pops one access unit and
+ * forwards it retimed (decode order preserved: DTS gets the tick time,
+ * PTS keeps its offset from DTS so B-frame reorder survives the
+ * retiming). On stall, replays the cached IDR-led GOP at cadence. On
+ * backlog overflow the queue is dropped wholesale and forwarding resyncs
+ * at the next keyframe - a decoder sees a gap followed by a clean IDR.
+ */
+static GstFlowReturn passthrough_tick(FrameBuffer *fb, GstClockTime pts,
+                                      GstClockTime duration, gboolean *is_repeat) {
+    GstBuffer *in = NULL;
+
+    if (g_async_queue_length(fb->au_queue) > 2 * fb->fps) {
+        GstBuffer *b;
+        while ((b = g_async_queue_try_pop(fb->au_queue)) != NULL) {
+            gst_buffer_unref(b);
+        }
+        fb->await_keyframe = TRUE;
+        fb_log(fb, "Passthrough: input backlog dropped, resyncing at next keyframe\n");
+    }
+
+    while ((in = g_async_queue_try_pop(fb->au_queue)) != NULL) {
+        if (fb->await_keyframe && GST_BUFFER_FLAG_IS_SET(in, GST_BUFFER_FLAG_DELTA_UNIT)) {
+            gst_buffer_unref(in);
+            continue;
+        }
+        fb->await_keyframe = FALSE;
+        break;
+    }
+
+    GstBuffer *out = NULL;
+
+    if (in) {
+        /* GOP cache maintenance: reset at every keyframe, cap absurd GOPs */
+        if (!GST_BUFFER_FLAG_IS_SET(in, GST_BUFFER_FLAG_DELTA_UNIT)) {
+            g_ptr_array_set_size(fb->gop_cache, 0);
+            fb->gop_complete = TRUE;
+        }
+        if (fb->gop_complete) {
+            if (fb->gop_cache->len < 600) {
+                g_ptr_array_add(fb->gop_cache, gst_buffer_ref(in));
+            } else {
+                g_ptr_array_set_size(fb->gop_cache, 0);
+                fb->gop_complete = FALSE;
+            }
+        }
+        fb->gop_pos = 0;
+        out = in;  /* Own ref transfers to the retiming below */
+    } else if (fb->gop_complete && fb->gop_cache->len > 0) {
+        /* Stall: replay the last complete GOP. Once we have replayed
+         * anything, the downstream decoder's reference pictures no longer
+         * match the live stream's - rejoin it only at the next keyframe,
+         * or the first live deltas would show reference corruption. */
+        GstBuffer *cached = g_ptr_array_index(fb->gop_cache, fb->gop_pos);
+        fb->gop_pos = (fb->gop_pos + 1) % fb->gop_cache->len;
+        out = gst_buffer_ref(cached);
+        fb->await_keyframe = TRUE;
+        *is_repeat = TRUE;
+    } else {
+        /* Nothing to forward and no GOP yet (channel just started) */
+        *is_repeat = TRUE;
+        return GST_FLOW_OK;
+    }
+
+    GstClockTime in_pts = GST_BUFFER_PTS(out);
+    GstClockTime in_dts = GST_BUFFER_DTS(out);
+    GstClockTime reorder_offset = 0;
+    if (GST_CLOCK_TIME_IS_VALID(in_pts) && GST_CLOCK_TIME_IS_VALID(in_dts) &&
+        in_pts > in_dts) {
+        reorder_offset = in_pts - in_dts;
+    }
+
+    out = gst_buffer_make_writable(out);
+    GST_BUFFER_DTS(out) = pts;
+    GST_BUFFER_PTS(out) = pts + reorder_offset;
+    GST_BUFFER_DURATION(out) = duration;
+
+    return enqueue_push(fb, fb->mux_appsrc, out);
+}
+
+/* Input streaming thread: sync mux caps, queue the parsed AU */
+static GstFlowReturn on_passthrough_sample(GstElement *sink, FrameBuffer *fb) {
+    GstSample *sample = gst_app_sink_pull_sample(GST_APP_SINK(sink));
+    if (!sample) return GST_FLOW_ERROR;
+
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstCaps *caps = gst_sample_get_caps(sample);
+
+    if (caps && (!fb->enc_caps || !gst_caps_is_equal(caps, fb->enc_caps))) {
+        if (fb->enc_caps) gst_caps_unref(fb->enc_caps);
+        fb->enc_caps = gst_caps_ref(caps);
+        g_object_set(fb->mux_appsrc, "caps", caps, NULL);
+    }
+
+    STAT_INC(fb->stats_in.frames_in);
+    guint64 arrival_ns = (guint64)g_get_monotonic_time() * 1000;
+    STAT_SET(fb->primary_last_ns, arrival_ns);
+    if (fb->jitter_adaptive) {
+        record_arrival_jitter(fb, arrival_ns);
+    }
+
+    g_async_queue_push(fb->au_queue, gst_buffer_ref(buffer));
+    gst_sample_unref(sample);
+    return GST_FLOW_OK;
+}
+
+/**
+ * Passthrough is only valid for h264 elementary streams into mpegts, rtp
+ * or raw UDP, and it supersedes the raw-domain extras. Called from both
+ * pipeline builders (input builds first), hence the idempotence flag.
+ */
+static void validate_passthrough(FrameBuffer *fb) {
+    if (!fb->passthrough || fb->passthrough_checked) return;
+    fb->passthrough_checked = TRUE;
+
+    if (fb->bench) {
+        fb_log(fb, "Passthrough has no meaning in benchmark mode, disabling\n");
+        fb->passthrough = FALSE;
+        return;
+    }
+    if (fb->codec != CODEC_H264 ||
+        (fb->container != CONTAINER_MPEGTS && fb->container != CONTAINER_RTP &&
+         fb->container != CONTAINER_RAW_UDP)) {
+        fb_log(fb, "Passthrough requires h264 to mpegts/rtp/raw output, disabling\n");
+        fb->passthrough = FALSE;
+        return;
+    }
+    if (fb->repeat_cache) {
+        fb_log(fb, "Passthrough supersedes the repeat cache, disabling the latter\n");
+        fb->repeat_cache = FALSE;
+    }
+    if (fb->backup_port > 0) {
+        fb_log(fb, "Backup input is not supported in passthrough mode, ignoring\n");
+        fb->backup_port = 0;
+    }
+
+    fb->au_queue = g_async_queue_new();
+    fb->gop_cache = g_ptr_array_new_with_free_func((GDestroyNotify)gst_buffer_unref);
+}
+
 /* ========== Render Loop ========== */
+
+/**
+ * Pacing accuracy is this tool's product; give the render thread
+ * scheduler guarantees when asked. SCHED_FIFO needs root or an rtprio
+ * rlimit; failures log and continue with normal scheduling.
+ */
+static void apply_render_thread_scheduling(FrameBuffer *fb) {
+    if (fb->rt_priority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = fb->rt_priority;
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0) {
+            fb_logerr(fb, "SCHED_FIFO %d failed: %s (need root or rtprio rlimit)\n",
+                      fb->rt_priority, g_strerror(err));
+        } else {
+            fb_log(fb, "Render thread: SCHED_FIFO priority %d\n", fb->rt_priority);
+        }
+    }
+
+    if (fb->cpu_affinity_mask != 0) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (guint i = 0; i < 64; i++) {
+            if (fb->cpu_affinity_mask & (1ULL << i)) {
+                CPU_SET(i, &set);
+            }
+        }
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            fb_logerr(fb, "CPU affinity 0x%" G_GINT64_MODIFIER "x failed: %s\n",
+                      fb->cpu_affinity_mask, g_strerror(err));
+        } else {
+            fb_log(fb, "Render thread: CPU affinity mask 0x%" G_GINT64_MODIFIER "x\n",
+                    fb->cpu_affinity_mask);
+        }
+#else
+        fb_log(fb, "CPU affinity is only supported on Linux, ignoring\n");
+#endif
+    }
+}
+
 static gpointer render_loop(gpointer data) {
     FrameBuffer *fb = (FrameBuffer *)data;
 
-    g_print("[FrameBuffer] Render loop started (%d fps)\n", fb->fps);
+    apply_render_thread_scheduling(fb);
+
+    fb_log(fb, "Render loop started (%d fps)\n", fb->fps);
 
     GstClock *clock = gst_pipeline_get_clock(GST_PIPELINE(fb->output_pipeline));
     if (!clock) {
-        g_printerr("[FrameBuffer] Failed to get pipeline clock\n");
+        fb_logerr(fb, "Failed to get pipeline clock\n");
         return NULL;
     }
 
     guint64 frame_count = 0;
-    guint64 stats_frames = (fb->stats_interval > 0) ? fb->fps * fb->stats_interval : 0;
+    guint64 repeat_run = 0;   /* Consecutive repeats, gates the repeat cache */
     gboolean signal_lost_logged = FALSE;
 
     while (fb->running) {
@@ -698,75 +2990,207 @@ static gpointer render_loop(gpointer data) {
         GstClockTime next_pts = gst_util_uint64_scale_int(frame_count + 1, GST_SECOND, fb->fps);
         GstClockTime duration = next_pts - pts;
 
-        g_mutex_lock(&fb->frame_mutex);
+        GstFlowReturn ret = GST_FLOW_OK;
 
-        /* Check for no-signal timeout: if last input was more than 5 seconds ago
-         * g_get_monotonic_time() returns microseconds, convert to nanoseconds */
-        gint64 now_us = g_get_monotonic_time();
-        GstClockTime now_ns = (GstClockTime)now_us * 1000;
-        gboolean signal_timeout = (fb->last_input_time > 0) &&
-                                  ((now_ns - fb->last_input_time) > DEFAULT_NO_SIGNAL_TIMEOUT);
-
-        if (fb->current_frame && !signal_timeout) {
-            /* Normal case: we have a valid, recent frame */
-            buffer_to_push = gst_buffer_copy(fb->current_frame);
-            current_seq = fb->in_seq;
-            signal_lost_logged = FALSE;
+        if (fb->passthrough) {
+            /* Compressed domain: retime/forward parsed AUs, replay the
+             * cached GOP on stall - no decode, no encode */
+            ret = passthrough_tick(fb, pts, duration, &is_repeat);
         } else {
-            /* No frame or signal timeout: use cached fallback frame */
-            use_fallback = TRUE;
-            is_repeat = TRUE;
-            if (signal_timeout && !signal_lost_logged) {
-                g_print("[FrameBuffer] No signal for 5s, switching to fallback frame\n");
-                signal_lost_logged = TRUE;
+            /* Pick up the newest published frame, if any. The flag test keeps us
+             * from swapping our last good frame away when nothing new arrived;
+             * when the flag is set, pending_slot is guaranteed to hold a newer
+             * frame than ours, so the exchange always trades up. Never blocks. */
+            if (g_atomic_int_compare_and_exchange(&fb->frame_available, 1, 0)) {
+                guint64 held_seq = fb->output_slot->seq;
+                fb->output_slot = g_atomic_pointer_exchange(&fb->pending_slot, fb->output_slot);
+                /* Rare interleaving: if the producer published between our flag
+                 * test and the exchange, the mailbox may hand us back a stale
+                 * slot while our newer frame ends up parked in pending. Trade
+                 * again until we hold a frame at least as new as before - the
+                 * mailbox then always contains our old slot or something newer,
+                 * so this loop runs at most twice. */
+                while (fb->output_slot->seq < held_seq) {
+                    fb->output_slot = g_atomic_pointer_exchange(&fb->pending_slot, fb->output_slot);
+                }
+            }
+            FrameSlot *slot = fb->output_slot;
+
+            /* Check for no-signal timeout: if last input was more than 5 seconds ago
+             * g_get_monotonic_time() returns microseconds, convert to nanoseconds */
+            gint64 now_us = g_get_monotonic_time();
+            GstClockTime now_ns = (GstClockTime)now_us * 1000;
+            gboolean signal_timeout = (slot->input_time > 0) &&
+                                      ((now_ns - slot->input_time) > DEFAULT_NO_SIGNAL_TIMEOUT);
+
+            if (slot->buffer && !signal_timeout) {
+                /* Normal case: we have a valid, recent frame.
+                 *
+                 * ZERO-COPY HANDOFF:
+                 * Take a reference instead of deep-copying the payload. At
+                 * 1080p60 I420 a full copy is ~3 MB per tick and dominates CPU
+                 * on multi-channel hosts. The input side never mutates a stored
+                 * buffer (on_new_sample() replaces the slot with a fresh decoder
+                 * buffer), so sharing the memory with the encoder is safe. */
+                buffer_to_push = gst_buffer_ref(slot->buffer);
+                current_seq = slot->seq;
+                signal_lost_logged = FALSE;
+            } else {
+                /* No frame or signal timeout: use cached fallback frame */
+                use_fallback = TRUE;
+                is_repeat = TRUE;
+                if (signal_timeout && !signal_lost_logged) {
+                    fb_log(fb, "No signal for 5s, switching to fallback frame\n");
+                    signal_lost_logged = TRUE;
+
+                    /* Repeat-cache mode: by now the cache holds the last
+                     * LIVE keyframe and raw frames no longer reach the
+                     * encoder, so without this swap a signal loss would
+                     * replay a freeze-frame forever instead of the slate */
+                    if (fb->repeat_cache && fb->slate_keyframe) {
+                        GstBuffer *old = g_atomic_pointer_exchange(
+                            &fb->cached_keyframe,
+                            gst_buffer_ref(fb->slate_keyframe));
+                        if (old) gst_buffer_unref(old);
+                    }
+                }
             }
-        }
 
-        g_mutex_unlock(&fb->frame_mutex);
+            /* Use pre-allocated fallback frame (ref'd, zero-copy like live frames) */
+            if (use_fallback) {
+                if (fb->fallback_frame) {
+                    buffer_to_push = gst_buffer_ref(fb->fallback_frame);
+                } else {
+                    /* Fallback not yet created - create one (should not happen normally) */
+                    buffer_to_push = create_fallback_frame(fb);
+                }
+            }
 
-        /* Use pre-allocated fallback frame (copy to avoid ownership issues) */
-        if (use_fallback) {
-            if (fb->fallback_frame) {
-                buffer_to_push = gst_buffer_copy(fb->fallback_frame);
-            } else {
-                /* Fallback not yet created - create one (should not happen normally) */
-                buffer_to_push = create_fallback_frame(fb);
+            /* Only track sequence for real frames, not fallback (avoid polluting with 0) */
+            if (!use_fallback) {
+                if (current_seq == fb->stats_out.last_pushed_seq) {
+                    is_repeat = TRUE;
+                } else if (fb->change_detect && slot->content_hash != 0 &&
+                           slot->content_hash == fb->stats_out.last_content_hash) {
+                    /* New frame, same picture: static slates and paused
+                     * players re-send identical frames forever - route them
+                     * through the repeat path (and repeat cache) instead of
+                     * treating them as fresh motion */
+                    is_repeat = TRUE;
+                } else {
+                    /* Fresh frame: record slot-store -> push latency (one array
+                     * increment, hot-path cheap) */
+                    latency_hist_add(&fb->latency, now_ns - slot->input_time);
+                    fb->stats_out.last_content_hash = slot->content_hash;
+                }
+                fb->stats_out.last_pushed_seq = current_seq;
             }
-        }
 
-        /* Only track sequence for real frames, not fallback (avoid polluting with 0) */
-        if (!use_fallback) {
-            if (current_seq == fb->last_pushed_seq) {
-                is_repeat = TRUE;
+            repeat_run = is_repeat ? repeat_run + 1 : 0;
+
+            gboolean pushed_cached = FALSE;
+
+            /* Repeat cache: once a stall has outlived one GOP, the cached
+             * keyframe is guaranteed to show the stalled picture - replay it
+             * retimed instead of re-encoding identical pixels every tick.
+             * Ownership is taken with an atomic exchange and handed back with
+             * a CAS so the encoder thread can publish a fresh keyframe
+             * concurrently. Short hiccups keep the pixel-accurate encode path. */
+            if (fb->repeat_cache && is_repeat &&
+                repeat_run > (guint64)fb->keyframe_interval) {
+                GstBuffer *cached = g_atomic_pointer_exchange(&fb->cached_keyframe, NULL);
+                if (cached) {
+                    GstBuffer *out = gst_buffer_make_writable(gst_buffer_ref(cached));
+                    GST_BUFFER_PTS(out) = pts;
+                    GST_BUFFER_DTS(out) = pts;
+                    GST_BUFFER_DURATION(out) = duration;
+                    ret = enqueue_push(fb, fb->mux_appsrc, out);
+                    if (!g_atomic_pointer_compare_and_exchange(&fb->cached_keyframe,
+                                                               NULL, cached)) {
+                        gst_buffer_unref(cached);  /* Encoder replaced it meanwhile */
+                    }
+                    gst_buffer_unref(buffer_to_push);  /* Raw repeat never hits the encoder */
+                    STAT_INC(fb->stats_out.frames_cached);
+                    pushed_cached = TRUE;
+                }
             }
-            fb->last_pushed_seq = current_seq;
-        }
 
-        /* Apply timestamps (do-timestamp=false on appsrc, we are clock master) */
-        GST_BUFFER_PTS(buffer_to_push) = pts;
-        GST_BUFFER_DTS(buffer_to_push) = pts;
-        GST_BUFFER_DURATION(buffer_to_push) = duration;
+            STAT_SET(fb->stats_out.signal_lost, use_fallback ? 1 : 0);
+
+            if (!pushed_cached) {
+                /* Apply timestamps (do-timestamp=false on appsrc, we are clock
+                 * master). The buffer is shared with the frame slot, so make it
+                 * writable first: for a shared buffer this copies only the
+                 * GstBuffer metadata (timestamps, flags) - the pixel GstMemory
+                 * stays refcounted, no memcpy. */
+                buffer_to_push = gst_buffer_make_writable(buffer_to_push);
+                GST_BUFFER_PTS(buffer_to_push) = pts;
+                GST_BUFFER_DTS(buffer_to_push) = pts;
+                GST_BUFFER_DURATION(buffer_to_push) = duration;
 
-        GstFlowReturn ret = gst_app_src_push_buffer(
-            GST_APP_SRC(fb->appsrc), buffer_to_push);
+                ret = enqueue_push(fb, fb->appsrc, buffer_to_push);
+            }
+
+            if (fb->audio_appsrc) {
+                audio_tick(fb, pts, duration);
+            }
+        }
 
         if (ret != GST_FLOW_OK) {
             if (ret == GST_FLOW_FLUSHING || ret == GST_FLOW_EOS) {
-                g_print("[FrameBuffer] Output pipeline flushing/EOS, stopping loop\n");
+                fb_log(fb, "Output pipeline flushing/EOS, stopping loop\n");
                 break;
             }
             /* Ignore other errors to keep loop alive */
         }
 
-        fb->frames_out++;
-        if (is_repeat) fb->frames_repeated++;
+        STAT_INC(fb->stats_out.frames_out);
+        if (is_repeat) STAT_INC(fb->stats_out.frames_repeated);
         frame_count++;
 
+        /* Recomputed per tick: stats-interval is live-settable over the
+         * control socket */
+        guint64 stats_frames = (fb->stats_interval > 0)
+            ? (guint64)fb->fps * fb->stats_interval
+            : 0;
         if (stats_frames > 0 && (frame_count % stats_frames) == 0) {
-            g_print("[FrameBuffer] Stats: in=%" G_GUINT64_FORMAT
-                    " out=%" G_GUINT64_FORMAT
-                    " repeated=%" G_GUINT64_FORMAT "\n",
-                    fb->frames_in, fb->frames_out, fb->frames_repeated);
+            StatsSnapshot snap;
+            stats_snapshot(fb, &snap);
+            if (fb->repeat_cache) {
+                fb_log(fb, "Stats: in=%" G_GUINT64_FORMAT
+                        " out=%" G_GUINT64_FORMAT
+                        " repeated=%" G_GUINT64_FORMAT
+                        " cached=%" G_GUINT64_FORMAT "\n",
+                        snap.frames_in, snap.frames_out, snap.frames_repeated,
+                        snap.frames_cached);
+            } else {
+                fb_log(fb, "Stats: in=%" G_GUINT64_FORMAT
+                        " out=%" G_GUINT64_FORMAT
+                        " repeated=%" G_GUINT64_FORMAT "\n",
+                        snap.frames_in, snap.frames_out, snap.frames_repeated);
+            }
+
+            /* Per-interval latency percentiles (slot-store -> push): drifting
+             * p95/p99 here flags jitter-buffer or encoder-queue growth long
+             * before downstream complains */
+            if (fb->latency.count > fb->latency_prev.count) {
+                LatencyHist interval;
+                latency_hist_diff(&fb->latency, &fb->latency_prev, &interval);
+                fb_log(fb, "Latency: p50=%ums p95=%ums p99=%ums max=%.1fms"
+                        " late_wakeups=%" G_GUINT64_FORMAT
+                        " pushq=%d dropped=%" G_GUINT64_FORMAT "\n",
+                        latency_hist_percentile(&interval, 50.0),
+                        latency_hist_percentile(&interval, 95.0),
+                        latency_hist_percentile(&interval, 99.0),
+                        (gdouble)interval.max_ns / 1e6,
+                        snap.wakeups_late,
+                        g_async_queue_length(fb->push_queue),
+                        STAT_READ(fb->stats_out.pushes_dropped));
+                fb->latency_prev = fb->latency;
+                /* We are the histogram's writer thread: safe to reset the
+                 * per-interval max here */
+                STAT_SET(fb->latency.interval_max_ns, 0);
+            }
         }
 
         /* Wait for next frame using same drift-free calculation
@@ -775,50 +3199,126 @@ static gpointer render_loop(gpointer data) {
         GstClockTime target_running_time = gst_util_uint64_scale_int(frame_count, GST_SECOND, fb->fps);
         GstClockTime target_time = base_time + target_running_time;
         GstClockID clk_id = gst_clock_new_single_shot_id(clock, target_time);
-        gst_clock_id_wait(clk_id, NULL);
+        GstClockTimeDiff wake_jitter = 0;
+        gst_clock_id_wait(clk_id, &wake_jitter);
         gst_clock_id_unref(clk_id);
+
+        /* Positive jitter = we woke up late. Count wakeups more than 1ms
+         * past target so --rt-priority improvements are verifiable. */
+        if (wake_jitter > (GstClockTimeDiff)GST_MSECOND) {
+            STAT_INC(fb->stats_out.wakeups_late);
+        }
     }
 
     gst_object_unref(clock);
 
-    g_print("[FrameBuffer] Render loop stopped\n");
+    fb_log(fb, "Render loop stopped\n");
     return NULL;
 }
 
 /* ========== Pipeline Start (Idle Callback) ========== */
+
+/* Everything input-related: pipeline (built here if fast-start deferred
+ * it), receive thread, backup input and warm standby */
+static gboolean start_input_side(FrameBuffer *fb) {
+    if (!fb->input_pipeline && !create_input_pipeline(fb)) {
+        fb_logerr(fb, "Failed to create input pipeline\n");
+        return FALSE;
+    }
+
+    gst_element_set_state(fb->input_pipeline, GST_STATE_PLAYING);
+    start_recv_thread(fb);
+
+    if (fb->backup_pipeline) {
+        gst_element_set_state(fb->backup_pipeline, GST_STATE_PLAYING);
+        fb->failover_timer_id = g_timeout_add(FAILOVER_CHECK_MS, failover_check, fb);
+    }
+
+    if (fb->warm_standby && !fb->bench && !fb->standby_pipeline) {
+        create_standby_input_pipeline(fb);
+    }
+
+    return TRUE;
+}
+
+static gboolean start_input_side_idle(gpointer data) {
+    FrameBuffer *fb = (FrameBuffer *)data;
+    if (start_input_side(fb)) {
+        fb_log(fb, "Input side up (fast-start deferred build)\n");
+    }
+    return G_SOURCE_REMOVE;
+}
 static gboolean start_pipelines_idle(gpointer data) {
     FrameBuffer *fb = (FrameBuffer *)data;
 
-    g_print("[FrameBuffer] Starting pipelines...\n");
+    fb_log(fb, "Starting pipelines...\n");
 
-    /* Pre-allocate fallback frame (grey) to avoid memory churn */
+    /* Pre-size the frame pool, then pre-allocate the grey fallback from it */
+    if (!fb->pool) {
+        if (create_frame_pool(fb)) {
+            fb_log(fb, "Frame pool pre-sized (%dx%d I420)\n", fb->width, fb->height);
+        }
+    }
     if (!fb->fallback_frame) {
-        fb->fallback_frame = create_fallback_frame(fb);
-        g_print("[FrameBuffer] Fallback frame pre-allocated\n");
+        if (fb->fallback_image) {
+            fb->fallback_frame = load_fallback_image(fb);
+            if (fb->fallback_frame) {
+                fb_log(fb, "Fallback slate loaded from %s\n", fb->fallback_image);
+            }
+        }
+        if (!fb->fallback_frame) {
+            fb->fallback_frame = create_fallback_frame(fb);
+            fb_log(fb, "Fallback frame pre-allocated\n");
+        }
+        preencode_fallback_slate(fb);
     }
 
     gst_element_set_state(fb->output_pipeline, GST_STATE_PLAYING);
+    if (fb->encode_pipeline) {
+        gst_element_set_state(fb->encode_pipeline, GST_STATE_PLAYING);
+    }
+
+    /* Feeder first: the pacer assumes the push queue exists */
+    if (!fb->push_queue) {
+        fb->push_queue = g_async_queue_new();
+    }
+    fb->push_thread = g_thread_new("push-feeder", push_loop, fb);
 
     fb->running = TRUE;
     fb->render_thread = g_thread_new("render-loop", render_loop, fb);
 
-    gst_element_set_state(fb->input_pipeline, GST_STATE_PLAYING);
+    /* Input side: inline classically; deferred to an idle callback in
+     * fast-start mode so the fallback output is already flowing while
+     * gst_parse_launch/decoder setup run off the critical path */
+    if (fb->fast_start) {
+        g_idle_add(start_input_side_idle, fb);
+    } else {
+        start_input_side(fb);
+    }
+
+    if (fb->stall_timeout_ms > 0 && !fb->bench) {
+        fb->watchdog_timer_id = g_timeout_add(WATCHDOG_CHECK_MS, watchdog_check, fb);
+    }
+
+    if (fb->jitter_adaptive && fb->input_proto == PROTO_UDP && !fb->bench) {
+        fb->jitter_timer_id = g_timeout_add(JITTER_ADAPT_CHECK_MS, jitter_adapt_check, fb);
+    }
 
-    g_print("[FrameBuffer] Running\n");
+    fb_log(fb, "Running\n");
 
     return G_SOURCE_REMOVE;
 }
 
 /* ========== Start ========== */
 static gboolean framebuffer_start(FrameBuffer *fb) {
-    g_print("[FrameBuffer] Scheduling startup...\n");
+    fb_log(fb, "Scheduling startup...\n");
     g_idle_add(start_pipelines_idle, fb);
     return TRUE;
 }
 
 /* ========== Stop ========== */
 static void framebuffer_stop(FrameBuffer *fb) {
-    g_print("[FrameBuffer] Stopping...\n");
+    fb_log(fb, "Stopping...\n");
 
     fb->running = FALSE;
 
@@ -827,30 +3327,96 @@ static void framebuffer_stop(FrameBuffer *fb) {
         fb->render_thread = NULL;
     }
 
-    gst_element_set_state(fb->input_pipeline, GST_STATE_NULL);
+    stop_push_thread(fb);
+
+    if (fb->failover_timer_id) {
+        g_source_remove(fb->failover_timer_id);
+        fb->failover_timer_id = 0;
+    }
+    if (fb->standby_build_id) {
+        g_source_remove(fb->standby_build_id);
+        fb->standby_build_id = 0;
+    }
+    if (fb->watchdog_timer_id) {
+        g_source_remove(fb->watchdog_timer_id);
+        fb->watchdog_timer_id = 0;
+    }
+    if (fb->jitter_timer_id) {
+        g_source_remove(fb->jitter_timer_id);
+        fb->jitter_timer_id = 0;
+    }
+
+    stop_recv_thread(fb);
+    if (fb->input_pipeline) {
+        gst_element_set_state(fb->input_pipeline, GST_STATE_NULL);
+    }
+    if (fb->backup_pipeline) {
+        gst_element_set_state(fb->backup_pipeline, GST_STATE_NULL);
+    }
+    if (fb->standby_pipeline) {
+        gst_element_set_state(fb->standby_pipeline, GST_STATE_NULL);
+    }
+    if (fb->encode_pipeline) {
+        gst_element_set_state(fb->encode_pipeline, GST_STATE_NULL);
+    }
     gst_element_set_state(fb->output_pipeline, GST_STATE_NULL);
 
-    g_print("[FrameBuffer] Stopped\n");
+    fb_log(fb, "Stopped\n");
 }
 
 /* ========== Cleanup ========== */
 static void framebuffer_free(FrameBuffer *fb) {
-    if (fb->current_frame) gst_buffer_unref(fb->current_frame);
+    /* Both threads are stopped here, slots can be drained without atomics */
+    for (gint i = 0; i < 3; i++) {
+        if (fb->slots[i].buffer) gst_buffer_unref(fb->slots[i].buffer);
+    }
+    if (fb->au_queue) {
+        GstBuffer *b;
+        while ((b = g_async_queue_try_pop(fb->au_queue)) != NULL) {
+            gst_buffer_unref(b);
+        }
+        g_async_queue_unref(fb->au_queue);
+    }
+    if (fb->gop_cache) g_ptr_array_free(fb->gop_cache, TRUE);
+    if (fb->audio_queue) {
+        GstBuffer *b;
+        while ((b = g_async_queue_try_pop(fb->audio_queue)) != NULL) {
+            gst_buffer_unref(b);
+        }
+        g_async_queue_unref(fb->audio_queue);
+    }
+    if (fb->silence_frame) gst_buffer_unref(fb->silence_frame);
+    if (fb->push_queue) g_async_queue_unref(fb->push_queue);
     if (fb->current_caps) gst_caps_unref(fb->current_caps);
     if (fb->fallback_frame) gst_buffer_unref(fb->fallback_frame);
+    if (fb->cached_keyframe) gst_buffer_unref(fb->cached_keyframe);
+    if (fb->slate_keyframe) gst_buffer_unref(fb->slate_keyframe);
+    if (fb->enc_caps) gst_caps_unref(fb->enc_caps);
     if (fb->input_pipeline) gst_object_unref(fb->input_pipeline);
+    if (fb->backup_pipeline) gst_object_unref(fb->backup_pipeline);
+    if (fb->standby_pipeline) gst_object_unref(fb->standby_pipeline);
+    if (fb->encode_pipeline) gst_object_unref(fb->encode_pipeline);
     if (fb->output_pipeline) gst_object_unref(fb->output_pipeline);
+    if (fb->pool) {
+        /* All pool buffers are back by now (slots and fallback unref'd above) */
+        gst_buffer_pool_set_active(fb->pool, FALSE);
+        gst_object_unref(fb->pool);
+    }
     g_free(fb->output_host);
+    if (fb->extra_dests) g_ptr_array_free(fb->extra_dests, TRUE);
+    g_free(fb->record_file);
     g_free(fb->shm_path);
-    g_mutex_clear(&fb->frame_mutex);
-    g_free(fb);
+    g_free(fb->output_file);
+    g_free(fb->fallback_image);
+    g_free(fb->log_name);
+    g_aligned_free(fb);
 }
 
 /* ========== Signal Handler ========== */
 static void signal_handler(int sig) {
     g_print("\n[FrameBuffer] Signal %d received, shutting down...\n", sig);
-    if (g_fb && g_fb->loop) {
-        g_main_loop_quit(g_fb->loop);
+    if (g_loop) {
+        g_main_loop_quit(g_loop);
     }
 }
 
@@ -864,11 +3430,40 @@ static void print_usage(const char *prog) {
     g_print("  -B, --udp-buffer SIZE      UDP socket buffer in bytes (default: %d)\n", DEFAULT_UDP_BUFFER_SIZE);
     g_print("  -j, --jitter-buffer MS     Jitter buffer in milliseconds (default: %d)\n", DEFAULT_JITTER_BUFFER_MS);
     g_print("  -Q, --max-queue MS         Max queue time in milliseconds (default: %d)\n", DEFAULT_MAX_QUEUE_TIME_MS);
+    g_print("      --jitter-adaptive      Size the jitter buffer from measured arrival\n");
+    g_print("                             statistics instead of the fixed -j value (udp only)\n");
+    g_print("      --jitter-min MS        Adaptive floor (default: %d)\n", DEFAULT_JITTER_MIN_MS);
+    g_print("      --jitter-max MS        Adaptive ceiling (default: %d)\n", DEFAULT_JITTER_MAX_MS);
+    g_print("      --input-accel MODE     GPU convert/scale: auto, none, gl, vaapi (default: none)\n");
+    g_print("      --input-engine ENGINE  UDP receive engine: stock, batched (default: stock)\n");
+    g_print("                             batched = recvmmsg batches, Linux only, cuts kernel CPU\n");
+    g_print("      --input-proto PROTO    Input transport: udp, srt, rist (default: udp)\n");
+    g_print("                             srt/rist map the jitter buffer onto their\n");
+    g_print("                             retransmission window instead of the queue\n");
+    g_print("      --backup-port PORT     Hot-standby UDP input; auto-promoted within a few\n");
+    g_print("                             frames of primary loss, demoted on recovery\n");
+    g_print("      --warm-standby         Keep a pre-built spare input pipeline in READY and\n");
+    g_print("                             promote it on input errors (fast recovery)\n");
+    g_print("      --stall-timeout MS     Restart input after MS without frames, exponential\n");
+    g_print("                             backoff, 0=off (default: %d)\n", DEFAULT_STALL_TIMEOUT_MS);
     g_print("\n");
 
     g_print("OUTPUT OPTIONS:\n");
     g_print("  -o, --output-port PORT     UDP output port (default: %d)\n", DEFAULT_OUTPUT_PORT);
     g_print("  -H, --host HOST            Output host/IP (default: %s)\n", DEFAULT_OUTPUT_HOST);
+    g_print("      --dest HOST:PORT       Additional destination (repeatable); the stream is\n");
+    g_print("                             encoded once and fanned out via multiudpsink\n");
+    g_print("      --record PATH          Record to PATH while streaming (tee after the\n");
+    g_print("                             encoder, one encode for send + archive)\n");
+    g_print("      --preview-port PORT    Low-cost monitoring tap: 320-wide MJPEG/RTP at\n");
+    g_print("                             --preview-fps (default 2) on PORT (default: off)\n");
+    g_print("      --change-detect        Sampled Y-plane checksum on input: sources that\n");
+    g_print("                             re-send identical pictures (static slates, paused\n");
+    g_print("                             players) take the cheap repeat path\n");
+    g_print("      --fast-start           Emit fallback frames within ~100ms of start; the\n");
+    g_print("                             input pipeline is built off the critical path\n");
+    g_print("      --prewarm              Prime the plugin registry cache and exit (run once\n");
+    g_print("                             before mass restarts)\n");
     g_print("  -w, --width WIDTH          Output width (default: %d)\n", DEFAULT_WIDTH);
     g_print("  -h, --height HEIGHT        Output height (default: %d)\n", DEFAULT_HEIGHT);
     g_print("  -f, --fps FPS              Output framerate (default: %d)\n", DEFAULT_FPS);
@@ -878,17 +3473,54 @@ static void print_usage(const char *prog) {
 
     g_print("OUTPUT FORMAT:\n");
     g_print("  -c, --codec CODEC          Output codec: raw, h264, h265, vp8, vp9 (default: h264)\n");
+    g_print("                             Shorthands: h264-vaapi, h264-nvenc, h265-nvenc, ... (codec + --hw)\n");
     g_print("  -C, --container CONT       Container: rtp, mpegts, shm, raw, file (default: mpegts)\n");
+    g_print("      --hw MODE              Hardware encoder: auto, none, vaapi, nvenc, v4l2 (default: none)\n");
+    g_print("                             auto probes VAAPI -> NVENC -> V4L2, falls back to software\n");
+    g_print("      --audio                Carry audio too: decoded, re-timed with silence\n");
+    g_print("                             fill, AAC-encoded into mpegts/mp4 outputs\n");
+    g_print("      --passthrough          Compressed-domain mode: retime/forward h264 access\n");
+    g_print("                             units without decode or re-encode; replays the last\n");
+    g_print("                             GOP on stall (h264 in, h264 to mpegts/rtp/raw out)\n");
+    g_print("      --repeat-cache         Replay the cached encoded keyframe on sustained stalls\n");
+    g_print("                             instead of re-encoding (h264/h265 to mpegts/rtp/raw)\n");
+    g_print("      --fallback-image PATH  PNG/JPEG slate decoded once at startup and shown on\n");
+    g_print("                             signal loss (with --repeat-cache it is also pre-encoded)\n");
     g_print("  -F, --file PATH            Output file path (auto-sets container to file)\n");
+    g_print("      --segment-seconds N    Rotate recordings every N seconds (splitmuxsink,\n");
+    g_print("                             rec.mp4 -> rec00000.mp4, ...; default: single file)\n");
     g_print("\n");
 
     g_print("SHARED MEMORY OPTIONS (when -C shm):\n");
     g_print("  -p, --shm-path PATH        Shared memory socket path (default: %s)\n", DEFAULT_SHM_PATH);
     g_print("  -Z, --shm-size SIZE        Shared memory size in bytes (default: %d)\n", DEFAULT_SHM_SIZE);
+    g_print("      --shm-engine ENGINE    stock (shmsink) or memfd (unixfdsink handle\n");
+    g_print("                             passing, zero-copy, GStreamer 1.24+) (default: stock)\n");
+    g_print("\n");
+
+    g_print("MULTI-CHANNEL:\n");
+    g_print("      --config FILE          Run one channel per [section] in FILE (ini style).\n");
+    g_print("                             Keys match the long option names; CLI options act\n");
+    g_print("                             as defaults for every channel.\n");
     g_print("\n");
 
     g_print("OTHER OPTIONS:\n");
     g_print("  -S, --stats-interval SEC   Stats print interval, 0=off (default: %d)\n", DEFAULT_STATS_INTERVAL_SEC);
+    g_print("      --bench SEC            Benchmark: synthetic input for SEC seconds, then a\n");
+    g_print("                             latency/CPU report (see also 'make bench')\n");
+    g_print("      --metrics-port PORT    HTTP metrics endpoint: /metrics (Prometheus) and\n");
+    g_print("                             /json, covering all channels (default: off)\n");
+    g_print("      --clock MODE           Slave output pacing to a clock: default, system,\n");
+    g_print("                             ptp, ntp - aligns outputs across the fleet\n");
+    g_print("      --clock-server HOST    NTP server for --clock ntp (default: pool.ntp.org)\n");
+    g_print("      --clock-domain N       PTP domain for --clock ptp (default: 0)\n");
+    g_print("      --rt-priority N        SCHED_FIFO priority for the render thread\n");
+    g_print("                             (needs root/rtprio rlimit; default: off)\n");
+    g_print("      --cpu-affinity MASK    Pin the render thread to CPUs in hex MASK\n");
+    g_print("                             (Linux only, e.g. 0c = cores 2,3; default: off)\n");
+    g_print("      --control-socket PATH  Unix socket for live reconfiguration, e.g.\n");
+    g_print("                             'set bitrate 4000', 'set sports keyframe 60',\n");
+    g_print("                             'set verbose on', 'get stats' (default: off)\n");
     g_print("  -V, --verbose              Verbose output (show pipeline strings)\n");
     g_print("      --help                 Show this help\n");
     g_print("      --version              Show version\n");
@@ -923,12 +3555,747 @@ static void print_version(void) {
     g_print("SoftwareFrameBuffer v%s\n", VERSION);
 }
 
+/* ========== Metrics Endpoint ========== */
+
+/* Coarse Prometheus histogram boundaries (ms), mapped onto the 1 ms
+ * LatencyHist buckets; 128 raw series per channel would be rude to scrape */
+static const guint metrics_latency_le[] = { 1, 2, 5, 10, 20, 50, 100 };
+
+static guint64 latency_hist_cumulative(const LatencyHist *h, guint le_ms) {
+    guint64 sum = 0;
+    for (guint i = 0; i < le_ms && i < LATENCY_BUCKETS; i++) {
+        sum += STAT_READ(h->buckets[i]);
+    }
+    return sum;
+}
+
+/* Counters are written by the streaming/render threads and read here
+ * without synchronization - fine for monitoring on 64-bit hosts */
+static void build_prometheus_metrics(GString *body) {
+    g_string_append(body,
+        "# TYPE framebuffer_frames_in counter\n"
+        "# TYPE framebuffer_frames_out counter\n"
+        "# TYPE framebuffer_frames_repeated counter\n"
+        "# TYPE framebuffer_frames_cached counter\n"
+        "# TYPE framebuffer_input_restarts counter\n"
+        "# TYPE framebuffer_failovers counter\n"
+        "# TYPE framebuffer_late_wakeups counter\n"
+        "# TYPE framebuffer_push_queue_depth gauge\n"
+        "# TYPE framebuffer_pushes_dropped counter\n"
+        "# TYPE framebuffer_signal_lost gauge\n"
+        "# TYPE framebuffer_latency_ms histogram\n");
+
+    for (guint i = 0; i < g_channels->len; i++) {
+        FrameBuffer *fb = g_ptr_array_index(g_channels, i);
+        const gchar *ch = fb->log_name;
+        StatsSnapshot snap;
+        stats_snapshot(fb, &snap);
+
+        g_string_append_printf(body,
+            "framebuffer_frames_in{channel=\"%s\"} %" G_GUINT64_FORMAT "\n"
+            "framebuffer_frames_out{channel=\"%s\"} %" G_GUINT64_FORMAT "\n"
+            "framebuffer_frames_repeated{channel=\"%s\"} %" G_GUINT64_FORMAT "\n"
+            "framebuffer_frames_cached{channel=\"%s\"} %" G_GUINT64_FORMAT "\n"
+            "framebuffer_input_restarts{channel=\"%s\"} %" G_GUINT64_FORMAT "\n"
+            "framebuffer_failovers{channel=\"%s\"} %" G_GUINT64_FORMAT "\n"
+            "framebuffer_late_wakeups{channel=\"%s\"} %" G_GUINT64_FORMAT "\n"
+            "framebuffer_push_queue_depth{channel=\"%s\"} %d\n"
+            "framebuffer_pushes_dropped{channel=\"%s\"} %" G_GUINT64_FORMAT "\n"
+            "framebuffer_signal_lost{channel=\"%s\"} %d\n",
+            ch, snap.frames_in,
+            ch, snap.frames_out,
+            ch, snap.frames_repeated,
+            ch, snap.frames_cached,
+            ch, fb->restart_count,
+            ch, fb->failover_count,
+            ch, snap.wakeups_late,
+            ch, fb->push_queue ? g_async_queue_length(fb->push_queue) : 0,
+            ch, STAT_READ(fb->stats_out.pushes_dropped),
+            ch, snap.signal_lost);
+
+        for (gsize b = 0; b < sizeof(metrics_latency_le) / sizeof(metrics_latency_le[0]); b++) {
+            g_string_append_printf(body,
+                "framebuffer_latency_ms_bucket{channel=\"%s\",le=\"%u\"} %" G_GUINT64_FORMAT "\n",
+                ch, metrics_latency_le[b],
+                latency_hist_cumulative(&fb->latency, metrics_latency_le[b]));
+        }
+        g_string_append_printf(body,
+            "framebuffer_latency_ms_bucket{channel=\"%s\",le=\"+Inf\"} %" G_GUINT64_FORMAT "\n"
+            "framebuffer_latency_ms_sum{channel=\"%s\"} %.3f\n"
+            "framebuffer_latency_ms_count{channel=\"%s\"} %" G_GUINT64_FORMAT "\n",
+            ch, STAT_READ(fb->latency.count),
+            ch, (gdouble)STAT_READ(fb->latency.total_ns) / 1e6,
+            ch, STAT_READ(fb->latency.count));
+    }
+}
+
+static void build_json_metrics(GString *body) {
+    g_string_append(body, "{\"channels\":[");
+    for (guint i = 0; i < g_channels->len; i++) {
+        FrameBuffer *fb = g_ptr_array_index(g_channels, i);
+        StatsSnapshot snap;
+        stats_snapshot(fb, &snap);
+        g_string_append_printf(body,
+            "%s{\"channel\":\"%s\",\"frames_in\":%" G_GUINT64_FORMAT
+            ",\"frames_out\":%" G_GUINT64_FORMAT
+            ",\"frames_repeated\":%" G_GUINT64_FORMAT
+            ",\"frames_cached\":%" G_GUINT64_FORMAT
+            ",\"input_restarts\":%" G_GUINT64_FORMAT
+            ",\"failovers\":%" G_GUINT64_FORMAT
+            ",\"late_wakeups\":%" G_GUINT64_FORMAT
+            ",\"signal_lost\":%d"
+            ",\"latency_ms\":{\"p50\":%u,\"p95\":%u,\"p99\":%u,\"max\":%.1f}}",
+            (i > 0) ? "," : "",
+            fb->log_name, snap.frames_in, snap.frames_out, snap.frames_repeated,
+            snap.frames_cached, fb->restart_count, fb->failover_count,
+            snap.wakeups_late, snap.signal_lost,
+            latency_hist_percentile(&fb->latency, 50.0),
+            latency_hist_percentile(&fb->latency, 95.0),
+            latency_hist_percentile(&fb->latency, 99.0),
+            (gdouble)STAT_READ(fb->latency.max_ns) / 1e6);
+    }
+    g_string_append(body, "]}\n");
+}
+
+/* One short-lived connection per scrape; the read/write runs on the main
+ * loop, which is fine for a lightweight poll every few seconds */
+static gboolean on_metrics_connection(GSocketService *service, GSocketConnection *conn,
+                                      GObject *source, gpointer data) {
+    (void)service;
+    (void)source;
+    (void)data;
+
+    /* The read runs on the shared main loop: bound it so a client that
+     * connects and sends nothing can't stall timers and bus dispatch */
+    g_socket_set_timeout(g_socket_connection_get_socket(conn), 2);
+
+    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(conn));
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(conn));
+
+    gchar req[1024];
+    gssize n = g_input_stream_read(in, req, sizeof(req) - 1, NULL, NULL);
+    if (n <= 0) {
+        return TRUE;
+    }
+    req[n] = '\0';
+
+    gboolean want_json = (strncmp(req, "GET /json", 9) == 0);
+
+    GString *body = g_string_new(NULL);
+    if (want_json) {
+        build_json_metrics(body);
+    } else {
+        build_prometheus_metrics(body);
+    }
+
+    gchar *resp = g_strdup_printf(
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: %s\r\n"
+        "Content-Length: %" G_GSIZE_FORMAT "\r\n"
+        "Connection: close\r\n"
+        "\r\n%s",
+        want_json ? "application/json" : "text/plain; version=0.0.4",
+        body->len, body->str);
+
+    g_output_stream_write_all(out, resp, strlen(resp), NULL, NULL, NULL);
+    g_io_stream_close(G_IO_STREAM(conn), NULL, NULL);
+
+    g_free(resp);
+    g_string_free(body, TRUE);
+    return TRUE;
+}
+
+static gboolean start_metrics_server(gint port) {
+    GSocketService *service = g_socket_service_new();
+    GError *error = NULL;
+
+    if (!g_socket_listener_add_inet_port(G_SOCKET_LISTENER(service), port, NULL, &error)) {
+        g_printerr("[FrameBuffer] Failed to bind metrics port %d: %s\n", port, error->message);
+        g_error_free(error);
+        g_object_unref(service);
+        return FALSE;
+    }
+
+    g_signal_connect(service, "incoming", G_CALLBACK(on_metrics_connection), NULL);
+    g_socket_service_start(service);
+    g_print("[FrameBuffer] Metrics: http://0.0.0.0:%d/metrics (Prometheus) and /json\n", port);
+    return TRUE;
+}
+
+/* ========== Runtime Control Socket ========== */
+
+/* Live-settable encoder property names per family; bitrate_scale converts
+ * our kbps config to the property's unit. NULLs = not supported live. */
+static void encoder_prop_names(FrameBuffer *fb, const char **bitrate_prop,
+                               const char **keyframe_prop, gint *bitrate_scale) {
+    *bitrate_prop = NULL;
+    *keyframe_prop = NULL;
+    *bitrate_scale = 1;
+
+    if (fb->hw != HW_NONE && fb->hw_factory) {
+        if (strncmp(fb->hw_factory, "vaapi", 5) == 0) {
+            *bitrate_prop = "bitrate";
+            *keyframe_prop = "keyframe-period";
+        } else if (strncmp(fb->hw_factory, "va", 2) == 0 ||
+                   strncmp(fb->hw_factory, "nv", 2) == 0) {
+            *bitrate_prop = "bitrate";
+            *keyframe_prop = (strncmp(fb->hw_factory, "nv", 2) == 0)
+                ? "gop-size" : "key-int-max";
+        }
+        /* v4l2: extra-controls only at build time, stays NULL */
+        return;
+    }
+
+    switch (fb->codec) {
+        case CODEC_H264:
+        case CODEC_H265:
+            *bitrate_prop = "bitrate";          /* kbps */
+            *keyframe_prop = "key-int-max";
+            break;
+        case CODEC_VP8:
+        case CODEC_VP9:
+            *bitrate_prop = "target-bitrate";   /* bps */
+            *keyframe_prop = "keyframe-max-dist";
+            *bitrate_scale = 1000;
+            break;
+        default:
+            break;
+    }
+}
+
+static GstElement *find_encoder(FrameBuffer *fb) {
+    GstElement *pipeline = fb->encode_pipeline ? fb->encode_pipeline : fb->output_pipeline;
+    return pipeline ? gst_bin_get_by_name(GST_BIN(pipeline), "enc") : NULL;
+}
+
+/* Apply one "set KEY VALUE" on a channel; appends a result line */
+static void channel_set_param(FrameBuffer *fb, const gchar *key,
+                              const gchar *value, GString *resp) {
+    if (strcmp(key, "bitrate") == 0 || strcmp(key, "keyframe") == 0) {
+        gint n = atoi(value);
+        if (n <= 0) {
+            g_string_append_printf(resp, "ERR %s: bad value '%s'\n", fb->log_name, value);
+            return;
+        }
+
+        const char *bitrate_prop, *keyframe_prop;
+        gint bitrate_scale;
+        encoder_prop_names(fb, &bitrate_prop, &keyframe_prop, &bitrate_scale);
+
+        gboolean is_bitrate = (strcmp(key, "bitrate") == 0);
+        const char *prop = is_bitrate ? bitrate_prop : keyframe_prop;
+
+        /* Remember for future pipeline (re)builds either way */
+        if (is_bitrate) fb->bitrate = n;
+        else fb->keyframe_interval = n;
+
+        GstElement *enc = find_encoder(fb);
+        if (!enc || !prop) {
+            if (enc) gst_object_unref(enc);
+            g_string_append_printf(resp,
+                "ERR %s: %s not live-settable for this encoder (stored for next rebuild)\n",
+                fb->log_name, key);
+            return;
+        }
+        g_object_set(enc, prop, is_bitrate ? n * bitrate_scale : n, NULL);
+        gst_object_unref(enc);
+        g_string_append_printf(resp, "OK %s %s=%d\n", fb->log_name, key, n);
+    } else if (strcmp(key, "stats-interval") == 0) {
+        fb->stats_interval = atoi(value);
+        g_string_append_printf(resp, "OK %s stats-interval=%d\n",
+                               fb->log_name, fb->stats_interval);
+    } else if (strcmp(key, "verbose") == 0) {
+        fb->verbose = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
+        g_string_append_printf(resp, "OK %s verbose=%d\n", fb->log_name, fb->verbose);
+    } else {
+        g_string_append_printf(resp, "ERR %s: unknown key '%s'\n", fb->log_name, key);
+    }
+}
+
+/* Match a channel by config section name ("sports") or full log name */
+static FrameBuffer *find_channel(const gchar *name) {
+    for (guint i = 0; i < g_channels->len; i++) {
+        FrameBuffer *fb = g_ptr_array_index(g_channels, i);
+        const gchar *colon = strchr(fb->log_name, ':');
+        if (strcmp(fb->log_name, name) == 0 ||
+            (colon && strcmp(colon + 1, name) == 0)) {
+            return fb;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Line protocol, one command per connection:
+ *   set KEY VALUE            apply to every channel
+ *   set CHANNEL KEY VALUE    apply to one channel (config section name)
+ *   get stats                JSON stats for all channels
+ * Tuning no longer needs a process restart (= seconds of lost output).
+ */
+static void control_dispatch(const gchar *line, GString *resp) {
+    gchar **tok = g_strsplit(line, " ", 0);
+    guint ntok = g_strv_length(tok);
+
+    if (ntok >= 2 && strcmp(tok[0], "get") == 0 && strcmp(tok[1], "stats") == 0) {
+        build_json_metrics(resp);
+    } else if (ntok == 3 && strcmp(tok[0], "set") == 0) {
+        for (guint i = 0; i < g_channels->len; i++) {
+            channel_set_param(g_ptr_array_index(g_channels, i), tok[1], tok[2], resp);
+        }
+    } else if (ntok == 4 && strcmp(tok[0], "set") == 0) {
+        FrameBuffer *fb = find_channel(tok[1]);
+        if (fb) {
+            channel_set_param(fb, tok[2], tok[3], resp);
+        } else {
+            g_string_append_printf(resp, "ERR unknown channel '%s'\n", tok[1]);
+        }
+    } else {
+        g_string_append(resp,
+            "ERR usage: set [CHANNEL] bitrate|keyframe|stats-interval|verbose VALUE | get stats\n");
+    }
+
+    g_strfreev(tok);
+}
+
+static gboolean on_control_connection(GSocketService *service, GSocketConnection *conn,
+                                      GObject *source, gpointer data) {
+    (void)service;
+    (void)source;
+    (void)data;
+
+    g_socket_set_timeout(g_socket_connection_get_socket(conn), 2);
+
+    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(conn));
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(conn));
+
+    gchar req[1024];
+    gssize n = g_input_stream_read(in, req, sizeof(req) - 1, NULL, NULL);
+    if (n <= 0) {
+        return TRUE;
+    }
+    req[n] = '\0';
+    g_strstrip(req);
+
+    GString *resp = g_string_new(NULL);
+    control_dispatch(req, resp);
+
+    g_output_stream_write_all(out, resp->str, resp->len, NULL, NULL, NULL);
+    g_io_stream_close(G_IO_STREAM(conn), NULL, NULL);
+    g_string_free(resp, TRUE);
+    return TRUE;
+}
+
+static gboolean start_control_server(const gchar *path) {
+    unlink(path);  /* Stale socket from a previous run */
+
+    GSocketService *service = g_socket_service_new();
+    GSocketAddress *addr = g_unix_socket_address_new(path);
+    GError *error = NULL;
+
+    if (!g_socket_listener_add_address(G_SOCKET_LISTENER(service), addr,
+                                       G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+                                       NULL, NULL, &error)) {
+        g_printerr("[FrameBuffer] Failed to bind control socket %s: %s\n",
+                   path, error->message);
+        g_error_free(error);
+        g_object_unref(addr);
+        g_object_unref(service);
+        return FALSE;
+    }
+    g_object_unref(addr);
+
+    g_signal_connect(service, "incoming", G_CALLBACK(on_control_connection), NULL);
+    g_socket_service_start(service);
+    g_print("[FrameBuffer] Control socket: %s\n", path);
+    return TRUE;
+}
+
+/* ========== Network Clock ========== */
+
+static ClockMode string_to_clock(const char *str) {
+    if (strcasecmp(str, "ptp") == 0) return CLOCK_PTP;
+    if (strcasecmp(str, "ntp") == 0) return CLOCK_NTP;
+    if (strcasecmp(str, "system") == 0) return CLOCK_SYSTEM;
+    return CLOCK_DEFAULT;
+}
+
+/**
+ * Build the process-wide clock every output pipeline (and thus the
+ * drift-free PTS math in the render loops) slaves to. With all hosts on
+ * the same PTP/NTP source, outputs across the fleet tick in lockstep and
+ * downstream consumers can shrink their buffers to near zero.
+ */
+static GstClock *create_network_clock(ClockMode mode, const gchar *server, gint domain) {
+    GstClock *clock = NULL;
+
+    switch (mode) {
+        case CLOCK_SYSTEM:
+            return gst_system_clock_obtain();
+        case CLOCK_PTP:
+            if (!gst_ptp_init(GST_PTP_CLOCK_ID_NONE, NULL)) {
+                g_printerr("[FrameBuffer] PTP init failed (needs CAP_NET_BIND_SERVICE "
+                           "or the ptp helper), using default clock\n");
+                return NULL;
+            }
+            clock = gst_ptp_clock_new("framebuffer-ptp", domain);
+            break;
+        case CLOCK_NTP:
+            clock = gst_ntp_clock_new("framebuffer-ntp",
+                                      server ? server : "pool.ntp.org", 123, 0);
+            break;
+        default:
+            return NULL;
+    }
+
+    if (clock && !gst_clock_wait_for_sync(clock, 10 * GST_SECOND)) {
+        g_print("[FrameBuffer] Network clock not synced after 10s, "
+                "continuing while it converges\n");
+    } else if (clock) {
+        g_print("[FrameBuffer] Network clock synced (%s)\n",
+                (mode == CLOCK_PTP) ? "ptp" : "ntp");
+    }
+    return clock;
+}
+
+/* ========== Benchmark Report ========== */
+
+static gboolean bench_quit_cb(gpointer data) {
+    (void)data;
+    g_print("[FrameBuffer] Benchmark duration reached\n");
+    if (g_loop) g_main_loop_quit(g_loop);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * Printed once per channel after the main loop quits in --bench mode.
+ * CPU time comes from getrusage (whole process - meaningful for the
+ * single-channel matrix `make bench` runs).
+ */
+static void print_bench_report(FrameBuffer *fb, const struct rusage *start_ru) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+
+    gdouble user_s = (ru.ru_utime.tv_sec - start_ru->ru_utime.tv_sec) +
+                     (ru.ru_utime.tv_usec - start_ru->ru_utime.tv_usec) / 1e6;
+    gdouble sys_s = (ru.ru_stime.tv_sec - start_ru->ru_stime.tv_sec) +
+                    (ru.ru_stime.tv_usec - start_ru->ru_stime.tv_usec) / 1e6;
+    StatsSnapshot snap;
+    stats_snapshot(fb, &snap);
+
+    gdouble cpu_per_frame_us = snap.frames_out
+        ? (user_s + sys_s) * 1e6 / (gdouble)snap.frames_out
+        : 0.0;
+
+    fb_log(fb, "===== Benchmark report =====\n");
+    fb_log(fb, "Config: %dx%d @ %dfps, codec=%s, container=%s, %ds\n",
+            fb->width, fb->height, fb->fps,
+            codec_to_string(fb->codec), container_to_string(fb->container),
+            fb->bench_duration);
+    fb_log(fb, "Frames: in=%" G_GUINT64_FORMAT " out=%" G_GUINT64_FORMAT
+            " repeated=%" G_GUINT64_FORMAT "\n",
+            snap.frames_in, snap.frames_out, snap.frames_repeated);
+    fb_log(fb, "Latency (slot->push): p50=%ums p95=%ums p99=%ums max=%.1fms (%" G_GUINT64_FORMAT " samples)\n",
+            latency_hist_percentile(&fb->latency, 50.0),
+            latency_hist_percentile(&fb->latency, 95.0),
+            latency_hist_percentile(&fb->latency, 99.0),
+            (gdouble)fb->latency.max_ns / 1e6,
+            fb->latency.count);
+    fb_log(fb, "CPU: user=%.2fs sys=%.2fs, %.1fus/frame, maxrss=%ldkB\n",
+            user_s, sys_s, cpu_per_frame_us, (long)ru.ru_maxrss);
+    fb_log(fb, "Allocations: %" G_GUINT64_FORMAT " frame-path heap allocations "
+            "(0 = the buffer pool held)\n",
+            STAT_READ(fb->frame_path_allocs));
+}
+
+/* ========== Multi-Channel Config ========== */
+
+/**
+ * Clone the CLI-configured template. Channels from a --config file start
+ * from whatever the command line set, then override per-channel keys.
+ */
+static FrameBuffer *framebuffer_clone(const FrameBuffer *tpl) {
+    FrameBuffer *fb = framebuffer_new();
+
+    fb->input_port = tpl->input_port;
+    fb->udp_buffer_size = tpl->udp_buffer_size;
+    fb->jitter_buffer_ms = tpl->jitter_buffer_ms;
+    fb->jitter_adaptive = tpl->jitter_adaptive;
+    fb->jitter_min_ms = tpl->jitter_min_ms;
+    fb->jitter_max_ms = tpl->jitter_max_ms;
+    fb->jitter_current_ms = tpl->jitter_current_ms;
+    fb->max_queue_time_ms = tpl->max_queue_time_ms;
+    fb->input_accel = tpl->input_accel;
+    fb->input_engine = tpl->input_engine;
+    fb->input_proto = tpl->input_proto;
+    fb->backup_port = tpl->backup_port;
+    fb->warm_standby = tpl->warm_standby;
+    fb->stall_timeout_ms = tpl->stall_timeout_ms;
+
+    fb->output_port = tpl->output_port;
+    g_free(fb->output_host);
+    fb->output_host = g_strdup(tpl->output_host);
+    if (tpl->extra_dests) {
+        fb->extra_dests = g_ptr_array_new_with_free_func(g_free);
+        for (guint i = 0; i < tpl->extra_dests->len; i++) {
+            g_ptr_array_add(fb->extra_dests,
+                            g_strdup(g_ptr_array_index(tpl->extra_dests, i)));
+        }
+    }
+    fb->record_file = tpl->record_file ? g_strdup(tpl->record_file) : NULL;
+    fb->preview_port = tpl->preview_port;
+    fb->preview_fps = tpl->preview_fps;
+    fb->width = tpl->width;
+    fb->height = tpl->height;
+    fb->fps = tpl->fps;
+    fb->bitrate = tpl->bitrate;
+    fb->keyframe_interval = tpl->keyframe_interval;
+
+    fb->codec = tpl->codec;
+    fb->container = tpl->container;
+    fb->hw = tpl->hw;
+    fb->repeat_cache = tpl->repeat_cache;
+    fb->passthrough = tpl->passthrough;
+    fb->audio_enable = tpl->audio_enable;
+    fb->fast_start = tpl->fast_start;
+    fb->change_detect = tpl->change_detect;
+
+    g_free(fb->shm_path);
+    fb->shm_path = g_strdup(tpl->shm_path);
+    fb->shm_size = tpl->shm_size;
+    fb->shm_zero_copy = tpl->shm_zero_copy;
+
+    fb->output_file = tpl->output_file ? g_strdup(tpl->output_file) : NULL;
+    fb->segment_seconds = tpl->segment_seconds;
+    fb->fallback_image = tpl->fallback_image ? g_strdup(tpl->fallback_image) : NULL;
+
+    fb->rt_priority = tpl->rt_priority;
+    fb->cpu_affinity_mask = tpl->cpu_affinity_mask;
+    fb->appsink_max_buffers = tpl->appsink_max_buffers;
+    fb->stats_interval = tpl->stats_interval;
+    fb->verbose = tpl->verbose;
+    fb->bench = tpl->bench;
+    fb->bench_duration = tpl->bench_duration;
+
+    return fb;
+}
+
+/* Per-channel keys use the same names as the long CLI options */
+static void channel_apply_config(FrameBuffer *fb, GKeyFile *kf, const gchar *group) {
+    gchar *s;
+
+    if (g_key_file_has_key(kf, group, "input-port", NULL))
+        fb->input_port = g_key_file_get_integer(kf, group, "input-port", NULL);
+    if (g_key_file_has_key(kf, group, "backup-port", NULL))
+        fb->backup_port = g_key_file_get_integer(kf, group, "backup-port", NULL);
+    if (g_key_file_has_key(kf, group, "warm-standby", NULL))
+        fb->warm_standby = g_key_file_get_boolean(kf, group, "warm-standby", NULL);
+    if (g_key_file_has_key(kf, group, "stall-timeout", NULL))
+        fb->stall_timeout_ms = g_key_file_get_uint64(kf, group, "stall-timeout", NULL);
+    if (g_key_file_has_key(kf, group, "passthrough", NULL))
+        fb->passthrough = g_key_file_get_boolean(kf, group, "passthrough", NULL);
+    if (g_key_file_has_key(kf, group, "audio", NULL))
+        fb->audio_enable = g_key_file_get_boolean(kf, group, "audio", NULL);
+    if (g_key_file_has_key(kf, group, "fast-start", NULL))
+        fb->fast_start = g_key_file_get_boolean(kf, group, "fast-start", NULL);
+    if (g_key_file_has_key(kf, group, "change-detect", NULL))
+        fb->change_detect = g_key_file_get_boolean(kf, group, "change-detect", NULL);
+    if (g_key_file_has_key(kf, group, "rt-priority", NULL))
+        fb->rt_priority = g_key_file_get_integer(kf, group, "rt-priority", NULL);
+    if ((s = g_key_file_get_string(kf, group, "cpu-affinity", NULL))) {
+        fb->cpu_affinity_mask = strtoull(s, NULL, 16);
+        g_free(s);
+    }
+    if (g_key_file_has_key(kf, group, "udp-buffer", NULL))
+        fb->udp_buffer_size = g_key_file_get_uint64(kf, group, "udp-buffer", NULL);
+    if (g_key_file_has_key(kf, group, "jitter-buffer", NULL)) {
+        fb->jitter_buffer_ms = g_key_file_get_uint64(kf, group, "jitter-buffer", NULL);
+        fb->jitter_current_ms = fb->jitter_buffer_ms;
+    }
+    if (g_key_file_has_key(kf, group, "jitter-adaptive", NULL))
+        fb->jitter_adaptive = g_key_file_get_boolean(kf, group, "jitter-adaptive", NULL);
+    if (g_key_file_has_key(kf, group, "jitter-min", NULL))
+        fb->jitter_min_ms = g_key_file_get_uint64(kf, group, "jitter-min", NULL);
+    if (g_key_file_has_key(kf, group, "jitter-max", NULL))
+        fb->jitter_max_ms = g_key_file_get_uint64(kf, group, "jitter-max", NULL);
+    if (g_key_file_has_key(kf, group, "max-queue", NULL))
+        fb->max_queue_time_ms = g_key_file_get_uint64(kf, group, "max-queue", NULL);
+    if ((s = g_key_file_get_string(kf, group, "input-accel", NULL))) {
+        fb->input_accel = string_to_accel(s);
+        g_free(s);
+    }
+    if ((s = g_key_file_get_string(kf, group, "input-engine", NULL))) {
+        fb->input_engine = string_to_engine(s);
+        g_free(s);
+    }
+    if ((s = g_key_file_get_string(kf, group, "input-proto", NULL))) {
+        fb->input_proto = string_to_proto(s);
+        g_free(s);
+    }
+
+    if (g_key_file_has_key(kf, group, "output-port", NULL))
+        fb->output_port = g_key_file_get_integer(kf, group, "output-port", NULL);
+    if ((s = g_key_file_get_string(kf, group, "host", NULL))) {
+        g_free(fb->output_host);
+        fb->output_host = s;
+    }
+    if (g_key_file_has_key(kf, group, "width", NULL))
+        fb->width = g_key_file_get_integer(kf, group, "width", NULL);
+    if (g_key_file_has_key(kf, group, "height", NULL))
+        fb->height = g_key_file_get_integer(kf, group, "height", NULL);
+    if (g_key_file_has_key(kf, group, "fps", NULL))
+        fb->fps = g_key_file_get_integer(kf, group, "fps", NULL);
+    if (g_key_file_has_key(kf, group, "bitrate", NULL))
+        fb->bitrate = g_key_file_get_integer(kf, group, "bitrate", NULL);
+    if (g_key_file_has_key(kf, group, "keyframe", NULL))
+        fb->keyframe_interval = g_key_file_get_integer(kf, group, "keyframe", NULL);
+
+    if ((s = g_key_file_get_string(kf, group, "codec", NULL))) {
+        fb->codec = string_to_codec(s, &fb->hw);
+        g_free(s);
+    }
+    if ((s = g_key_file_get_string(kf, group, "container", NULL))) {
+        fb->container = string_to_container(s);
+        g_free(s);
+    }
+    if ((s = g_key_file_get_string(kf, group, "hw", NULL))) {
+        fb->hw = string_to_hw(s);
+        g_free(s);
+    }
+
+    if ((s = g_key_file_get_string(kf, group, "shm-path", NULL))) {
+        g_free(fb->shm_path);
+        fb->shm_path = s;
+    }
+    if (g_key_file_has_key(kf, group, "shm-size", NULL))
+        fb->shm_size = g_key_file_get_uint64(kf, group, "shm-size", NULL);
+    if ((s = g_key_file_get_string(kf, group, "shm-engine", NULL))) {
+        fb->shm_zero_copy = (strcasecmp(s, "memfd") == 0);
+        g_free(s);
+    }
+
+    if ((s = g_key_file_get_string(kf, group, "file", NULL))) {
+        g_free(fb->output_file);
+        fb->output_file = s;
+        fb->container = CONTAINER_FILE;
+    }
+    if (g_key_file_has_key(kf, group, "segment-seconds", NULL))
+        fb->segment_seconds = g_key_file_get_integer(kf, group, "segment-seconds", NULL);
+    if ((s = g_key_file_get_string(kf, group, "dests", NULL))) {
+        /* Comma-separated host:port list */
+        gchar **dests = g_strsplit(s, ",", 0);
+        if (fb->extra_dests) g_ptr_array_free(fb->extra_dests, TRUE);
+        fb->extra_dests = g_ptr_array_new_with_free_func(g_free);
+        for (guint i = 0; dests[i]; i++) {
+            g_ptr_array_add(fb->extra_dests, g_strdup(g_strstrip(dests[i])));
+        }
+        g_strfreev(dests);
+        g_free(s);
+    }
+    if ((s = g_key_file_get_string(kf, group, "record", NULL))) {
+        g_free(fb->record_file);
+        fb->record_file = s;
+    }
+    if (g_key_file_has_key(kf, group, "preview-port", NULL))
+        fb->preview_port = g_key_file_get_integer(kf, group, "preview-port", NULL);
+    if (g_key_file_has_key(kf, group, "preview-fps", NULL))
+        fb->preview_fps = g_key_file_get_integer(kf, group, "preview-fps", NULL);
+
+    if (g_key_file_has_key(kf, group, "stats-interval", NULL))
+        fb->stats_interval = g_key_file_get_integer(kf, group, "stats-interval", NULL);
+    if (g_key_file_has_key(kf, group, "verbose", NULL))
+        fb->verbose = g_key_file_get_boolean(kf, group, "verbose", NULL);
+}
+
+/**
+ * Load N channels from a GKeyFile config. Every [section] becomes one
+ * channel; section names only matter for logging. One process then runs
+ * all channels on a shared main loop and a single GStreamer registry,
+ * instead of 30-60 separate framebuffer processes per host.
+ */
+static gboolean load_channels_from_config(const gchar *path, const FrameBuffer *tpl,
+                                          GPtrArray *channels) {
+    GKeyFile *kf = g_key_file_new();
+    GError *error = NULL;
+
+    if (!g_key_file_load_from_file(kf, path, G_KEY_FILE_NONE, &error)) {
+        g_printerr("[FrameBuffer] Failed to load config %s: %s\n", path, error->message);
+        g_error_free(error);
+        g_key_file_free(kf);
+        return FALSE;
+    }
+
+    gsize n_groups = 0;
+    gchar **groups = g_key_file_get_groups(kf, &n_groups);
+
+    if (n_groups == 0) {
+        g_printerr("[FrameBuffer] Config %s contains no channel sections\n", path);
+        g_strfreev(groups);
+        g_key_file_free(kf);
+        return FALSE;
+    }
+
+    for (gsize i = 0; i < n_groups; i++) {
+        FrameBuffer *ch = framebuffer_clone(tpl);
+        g_free(ch->log_name);
+        ch->log_name = g_strdup_printf("FrameBuffer:%s", groups[i]);
+        channel_apply_config(ch, kf, groups[i]);
+        g_ptr_array_add(channels, ch);
+    }
+
+    g_print("[FrameBuffer] Loaded %" G_GSIZE_FORMAT " channel(s) from %s\n", n_groups, path);
+
+    g_strfreev(groups);
+    g_key_file_free(kf);
+    return TRUE;
+}
+
 /* ========== Main ========== */
 int main(int argc, char *argv[]) {
     gst_init(&argc, &argv);
 
     FrameBuffer *fb = framebuffer_new();
-    g_fb = fb;
+    const gchar *config_path = NULL;
+    const gchar *control_socket_path = NULL;
+    gint metrics_port = 0;
+    ClockMode clock_mode = CLOCK_DEFAULT;
+    const gchar *clock_server = NULL;
+    gint clock_domain = 0;
+
+    /* Long-only options (no short letter) */
+    enum {
+        OPT_HW = 1000,
+        OPT_INPUT_ACCEL,
+        OPT_CONFIG,
+        OPT_REPEAT_CACHE,
+        OPT_FALLBACK_IMAGE,
+        OPT_BENCH,
+        OPT_METRICS_PORT,
+        OPT_INPUT_ENGINE,
+        OPT_INPUT_PROTO,
+        OPT_BACKUP_PORT,
+        OPT_WARM_STANDBY,
+        OPT_STALL_TIMEOUT,
+        OPT_CONTROL_SOCKET,
+        OPT_PASSTHROUGH,
+        OPT_SHM_ENGINE,
+        OPT_RT_PRIORITY,
+        OPT_CPU_AFFINITY,
+        OPT_JITTER_ADAPTIVE,
+        OPT_JITTER_MIN,
+        OPT_JITTER_MAX,
+        OPT_SEGMENT_SECONDS,
+        OPT_AUDIO,
+        OPT_DEST,
+        OPT_RECORD,
+        OPT_CLOCK,
+        OPT_CLOCK_SERVER,
+        OPT_CLOCK_DOMAIN,
+        OPT_PREVIEW_PORT,
+        OPT_PREVIEW_FPS,
+        OPT_FAST_START,
+        OPT_PREWARM,
+        OPT_CHANGE_DETECT
+    };
 
     static struct option long_options[] = {
         {"input-port",    required_argument, 0, 'i'},
@@ -944,6 +4311,38 @@ int main(int argc, char *argv[]) {
         {"keyframe",      required_argument, 0, 'k'},
         {"codec",         required_argument, 0, 'c'},
         {"container",     required_argument, 0, 'C'},
+        {"hw",            required_argument, 0, OPT_HW},
+        {"input-accel",   required_argument, 0, OPT_INPUT_ACCEL},
+        {"input-engine",  required_argument, 0, OPT_INPUT_ENGINE},
+        {"input-proto",   required_argument, 0, OPT_INPUT_PROTO},
+        {"backup-port",   required_argument, 0, OPT_BACKUP_PORT},
+        {"warm-standby",  no_argument,       0, OPT_WARM_STANDBY},
+        {"stall-timeout", required_argument, 0, OPT_STALL_TIMEOUT},
+        {"control-socket",required_argument, 0, OPT_CONTROL_SOCKET},
+        {"passthrough",   no_argument,       0, OPT_PASSTHROUGH},
+        {"shm-engine",    required_argument, 0, OPT_SHM_ENGINE},
+        {"rt-priority",   required_argument, 0, OPT_RT_PRIORITY},
+        {"cpu-affinity",  required_argument, 0, OPT_CPU_AFFINITY},
+        {"jitter-adaptive",no_argument,      0, OPT_JITTER_ADAPTIVE},
+        {"jitter-min",    required_argument, 0, OPT_JITTER_MIN},
+        {"jitter-max",    required_argument, 0, OPT_JITTER_MAX},
+        {"segment-seconds",required_argument,0, OPT_SEGMENT_SECONDS},
+        {"audio",         no_argument,       0, OPT_AUDIO},
+        {"dest",          required_argument, 0, OPT_DEST},
+        {"record",        required_argument, 0, OPT_RECORD},
+        {"clock",         required_argument, 0, OPT_CLOCK},
+        {"clock-server",  required_argument, 0, OPT_CLOCK_SERVER},
+        {"clock-domain",  required_argument, 0, OPT_CLOCK_DOMAIN},
+        {"preview-port",  required_argument, 0, OPT_PREVIEW_PORT},
+        {"preview-fps",   required_argument, 0, OPT_PREVIEW_FPS},
+        {"fast-start",    no_argument,       0, OPT_FAST_START},
+        {"prewarm",       no_argument,       0, OPT_PREWARM},
+        {"change-detect", no_argument,       0, OPT_CHANGE_DETECT},
+        {"config",        required_argument, 0, OPT_CONFIG},
+        {"repeat-cache",  no_argument,       0, OPT_REPEAT_CACHE},
+        {"fallback-image",required_argument, 0, OPT_FALLBACK_IMAGE},
+        {"bench",         required_argument, 0, OPT_BENCH},
+        {"metrics-port",  required_argument, 0, OPT_METRICS_PORT},
         {"shm-path",      required_argument, 0, 'p'},
         {"shm-size",      required_argument, 0, 'Z'},
         {"file",          required_argument, 0, 'F'},
@@ -968,6 +4367,7 @@ int main(int argc, char *argv[]) {
                 break;
             case 'j':
                 fb->jitter_buffer_ms = strtoull(optarg, NULL, 10);
+                fb->jitter_current_ms = fb->jitter_buffer_ms;
                 break;
             case 'Q':
                 fb->max_queue_time_ms = strtoull(optarg, NULL, 10);
@@ -995,7 +4395,114 @@ int main(int argc, char *argv[]) {
                 fb->keyframe_interval = atoi(optarg);
                 break;
             case 'c':
-                fb->codec = string_to_codec(optarg);
+                fb->codec = string_to_codec(optarg, &fb->hw);
+                break;
+            case OPT_HW:
+                fb->hw = string_to_hw(optarg);
+                break;
+            case OPT_INPUT_ACCEL:
+                fb->input_accel = string_to_accel(optarg);
+                break;
+            case OPT_INPUT_ENGINE:
+                fb->input_engine = string_to_engine(optarg);
+                break;
+            case OPT_INPUT_PROTO:
+                fb->input_proto = string_to_proto(optarg);
+                break;
+            case OPT_BACKUP_PORT:
+                fb->backup_port = atoi(optarg);
+                break;
+            case OPT_WARM_STANDBY:
+                fb->warm_standby = TRUE;
+                break;
+            case OPT_STALL_TIMEOUT:
+                fb->stall_timeout_ms = strtoull(optarg, NULL, 10);
+                break;
+            case OPT_CONTROL_SOCKET:
+                control_socket_path = optarg;
+                break;
+            case OPT_PASSTHROUGH:
+                fb->passthrough = TRUE;
+                break;
+            case OPT_SHM_ENGINE:
+                fb->shm_zero_copy = (strcasecmp(optarg, "memfd") == 0);
+                break;
+            case OPT_RT_PRIORITY:
+                fb->rt_priority = atoi(optarg);
+                break;
+            case OPT_CPU_AFFINITY:
+                fb->cpu_affinity_mask = strtoull(optarg, NULL, 16);
+                break;
+            case OPT_JITTER_ADAPTIVE:
+                fb->jitter_adaptive = TRUE;
+                break;
+            case OPT_JITTER_MIN:
+                fb->jitter_min_ms = strtoull(optarg, NULL, 10);
+                break;
+            case OPT_JITTER_MAX:
+                fb->jitter_max_ms = strtoull(optarg, NULL, 10);
+                break;
+            case OPT_SEGMENT_SECONDS:
+                fb->segment_seconds = atoi(optarg);
+                break;
+            case OPT_AUDIO:
+                fb->audio_enable = TRUE;
+                break;
+            case OPT_DEST:
+                if (!fb->extra_dests) {
+                    fb->extra_dests = g_ptr_array_new_with_free_func(g_free);
+                }
+                g_ptr_array_add(fb->extra_dests, g_strdup(optarg));
+                break;
+            case OPT_RECORD:
+                g_free(fb->record_file);
+                fb->record_file = g_strdup(optarg);
+                break;
+            case OPT_CLOCK:
+                clock_mode = string_to_clock(optarg);
+                break;
+            case OPT_CLOCK_SERVER:
+                clock_server = optarg;
+                break;
+            case OPT_CLOCK_DOMAIN:
+                clock_domain = atoi(optarg);
+                break;
+            case OPT_PREVIEW_PORT:
+                fb->preview_port = atoi(optarg);
+                break;
+            case OPT_PREVIEW_FPS:
+                fb->preview_fps = atoi(optarg);
+                if (fb->preview_fps <= 0) fb->preview_fps = 2;
+                break;
+            case OPT_FAST_START:
+                fb->fast_start = TRUE;
+                break;
+            case OPT_CHANGE_DETECT:
+                fb->change_detect = TRUE;
+                break;
+            case OPT_PREWARM:
+                /* gst_init above already (re)built the registry cache; a
+                 * prewarm run before a mass restart makes the real starts
+                 * read it warm instead of rescanning plugins */
+                g_print("[FrameBuffer] Registry prewarmed\n");
+                return 0;
+            case OPT_CONFIG:
+                config_path = optarg;
+                break;
+            case OPT_REPEAT_CACHE:
+                fb->repeat_cache = TRUE;
+                break;
+            case OPT_FALLBACK_IMAGE:
+                g_free(fb->fallback_image);
+                fb->fallback_image = g_strdup(optarg);
+                break;
+            case OPT_BENCH:
+                fb->bench = TRUE;
+                fb->bench_duration = atoi(optarg);
+                if (fb->bench_duration <= 0) fb->bench_duration = 30;
+                break;
+            case OPT_METRICS_PORT:
+                metrics_port = atoi(optarg);
                 break;
             case 'C':
                 fb->container = string_to_container(optarg);
@@ -1034,28 +4541,95 @@ int main(int argc, char *argv[]) {
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
-    if (!create_input_pipeline(fb)) {
-        g_printerr("Failed to create input pipeline\n");
-        return 1;
+    /* Channel set: one entry in classic CLI mode, N entries with --config.
+     * All channels share this process, main loop and plugin registry -
+     * gst_init and the registry scan are paid once per host, not per channel. */
+    GPtrArray *channels = g_ptr_array_new();
+
+    if (config_path) {
+        if (!load_channels_from_config(config_path, fb, channels)) {
+            return 1;
+        }
+    } else {
+        g_ptr_array_add(channels, fb);
+    }
+
+    if (clock_mode != CLOCK_DEFAULT) {
+        g_net_clock = create_network_clock(clock_mode, clock_server, clock_domain);
+    }
+
+    for (guint i = 0; i < channels->len; i++) {
+        FrameBuffer *ch = g_ptr_array_index(channels, i);
+
+        /* Fast start: only the output side blocks startup; the input
+         * pipeline is built from an idle callback once frames are flowing */
+        if (!ch->fast_start && !create_input_pipeline(ch)) {
+            fb_logerr(ch, "Failed to create input pipeline\n");
+            return 1;
+        }
+
+        if (!create_output_pipeline(ch)) {
+            fb_logerr(ch, "Failed to create output pipeline\n");
+            return 1;
+        }
+
+        /* Slave the paced side to the shared network clock: the render
+         * loop takes its clock from the output pipeline, so every channel
+         * (and every host on the same PTP/NTP source) ticks in lockstep */
+        if (g_net_clock) {
+            gst_pipeline_use_clock(GST_PIPELINE(ch->output_pipeline), g_net_clock);
+            if (ch->encode_pipeline) {
+                gst_pipeline_use_clock(GST_PIPELINE(ch->encode_pipeline), g_net_clock);
+            }
+        }
+    }
+
+    g_channels = channels;
+    if (metrics_port > 0) {
+        start_metrics_server(metrics_port);
+    }
+    if (control_socket_path) {
+        start_control_server(control_socket_path);
+    }
+
+    g_loop = g_main_loop_new(NULL, FALSE);
+
+    for (guint i = 0; i < channels->len; i++) {
+        FrameBuffer *ch = g_ptr_array_index(channels, i);
+        if (!framebuffer_start(ch)) {
+            fb_logerr(ch, "Failed to schedule frame buffer start\n");
+            return 1;
+        }
     }
 
-    if (!create_output_pipeline(fb)) {
-        g_printerr("Failed to create output pipeline\n");
-        return 1;
+    struct rusage bench_start_ru;
+    if (fb->bench) {
+        getrusage(RUSAGE_SELF, &bench_start_ru);
+        g_timeout_add_seconds(fb->bench_duration, bench_quit_cb, NULL);
     }
 
-    fb->loop = g_main_loop_new(NULL, FALSE);
+    g_main_loop_run(g_loop);
+
+    for (guint i = 0; i < channels->len; i++) {
+        framebuffer_stop(g_ptr_array_index(channels, i));
+    }
 
-    if (!framebuffer_start(fb)) {
-        g_printerr("Failed to schedule frame buffer start\n");
-        return 1;
+    if (fb->bench) {
+        for (guint i = 0; i < channels->len; i++) {
+            print_bench_report(g_ptr_array_index(channels, i), &bench_start_ru);
+        }
     }
 
-    g_main_loop_run(fb->loop);
+    g_main_loop_unref(g_loop);
+    g_loop = NULL;
 
-    framebuffer_stop(fb);
-    g_main_loop_unref(fb->loop);
-    framebuffer_free(fb);
+    for (guint i = 0; i < channels->len; i++) {
+        framebuffer_free(g_ptr_array_index(channels, i));
+    }
+    g_ptr_array_free(channels, TRUE);
+    if (config_path) {
+        framebuffer_free(fb);  /* Template was only cloned, never started */
+    }
 
     return 0;
 }